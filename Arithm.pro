@@ -15,11 +15,47 @@ RC_ICONS = $$PWD/media/Arithm.ico
 RESOURCES = Arithm.qrc
 
 SOURCES += \
+    arithm_budget.cpp \
+    arithm_cache.cpp \
+    arithm_dataset.cpp \
     arithm_dialog.cpp \
+    arithm_evaluator.cpp \
+    arithm_extrema.cpp \
+    arithm_field.cpp \
+    arithm_history.cpp \
+    arithm_history_index.cpp \
+    arithm_implicit.cpp \
+    arithm_library.cpp \
+    arithm_optimizer.cpp \
+    arithm_plot.cpp \
+    arithm_precompiler.cpp \
+    arithm_roots.cpp \
+    arithm_split.cpp \
+    arithm_sweep.cpp \
+    arithm_task.cpp \
+    arithm_tiles.cpp \
     main.cpp \
 
 HEADERS += \
+    arithm_budget.h \
+    arithm_cache.h \
+    arithm_dataset.h \
     arithm_dialog.h \
+    arithm_evaluator.h \
+    arithm_extrema.h \
+    arithm_field.h \
+    arithm_history.h \
+    arithm_history_index.h \
+    arithm_implicit.h \
+    arithm_library.h \
+    arithm_optimizer.h \
+    arithm_plot.h \
+    arithm_precompiler.h \
+    arithm_roots.h \
+    arithm_split.h \
+    arithm_sweep.h \
+    arithm_task.h \
+    arithm_tiles.h \
     exprtk/exprtk.hpp \ \
     settings.h
 
@@ -0,0 +1,93 @@
+#include "arithm_budget.h"
+
+#include <stdexcept>
+
+ArithmBudget::ArithmBudget()
+    : m_Cancellations(0)
+{
+}
+
+ArithmBudget::ArithmBudget(const ArithmBudget *parent)
+    : m_Cancellations(0), m_Parent(parent)
+{
+    if(parent)
+    {
+        max_loop_iterations = parent->max_loop_iterations;
+        m_Timeout = parent->m_Timeout;
+        m_ParentStarted = parent->m_Cancellations;
+    }
+}
+
+void ArithmBudget::setMaxIterations(count_t maxIterations)
+{
+    max_loop_iterations = maxIterations;
+}
+
+void ArithmBudget::setTimeout(qint64 timeout)
+{
+    m_Timeout = timeout;
+}
+
+void ArithmBudget::start()
+{
+    m_Started = m_Cancellations;
+    m_Timer.start();
+}
+
+void ArithmBudget::resume()
+{
+    if(!m_Parent || !m_Parent->m_Timer.isValid())
+    {
+        start();
+        return;
+    }
+
+    m_Started = m_Cancellations;
+    m_Timer = m_Parent->m_Timer;
+}
+
+void ArithmBudget::cancel()
+{
+    m_Cancellations++;
+}
+
+bool ArithmBudget::isCancelled() const
+{
+    return m_Cancellations != m_Started || (m_Parent && m_Parent->m_Cancellations != m_ParentStarted);
+}
+
+void ArithmBudget::checkpoint()
+{
+    if(!check())
+    {
+        violation_context context;
+        context.loop = e_invalid;
+        context.violation = e_runtime_check;
+        context.iteration_count = 0;
+
+        handle_runtime_violation(context);
+    }
+}
+
+bool ArithmBudget::check()
+{
+    if(isCancelled())
+        return false;
+
+    // No timeout configured
+    if(m_Timeout <= 0 || !m_Timer.isValid())
+        return true;
+
+    return !m_Timer.hasExpired(m_Timeout);
+}
+
+void ArithmBudget::handle_runtime_violation(const violation_context &context)
+{
+    if(context.violation == e_iteration_count)
+        throw std::runtime_error("Loop iteration limit of " + std::to_string(max_loop_iterations) + " exceeded");
+
+    if(isCancelled())
+        throw std::runtime_error("Evaluation cancelled");
+
+    throw std::runtime_error("Evaluation exceeded " + std::to_string(m_Timeout) + " ms");
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <atomic>
+
+#include "exprtk.hpp"
+
+// Evaluation budget (loop iterations, wall-clock deadline and cancellation)
+class ArithmBudget : public exprtk::loop_runtime_check
+{
+public:
+    ArithmBudget();
+
+    // Same limits as the given budget (if any), with a deadline of its own,
+    // cancelled when the given budget is cancelled after this point
+    explicit ArithmBudget(const ArithmBudget *parent);
+
+    void setMaxIterations(count_t maxIterations);
+    void setTimeout(qint64 timeout);
+
+    // Starts the deadline, earlier cancellations of this budget no longer apply
+    void start();
+
+    // Continues the deadline of the budget this one was derived from, if that was started,
+    // so that tasks sharing this budget finish within it
+    void resume();
+
+    // Aborts evaluations under this budget and the budgets derived from it until they start again
+    void cancel();
+    bool isCancelled() const;
+
+    // Throws if the budget has been exhausted
+    void checkpoint();
+
+    bool check() override;
+    void handle_runtime_violation(const violation_context &context) override;
+
+private:
+    QElapsedTimer m_Timer;
+    qint64 m_Timeout = 0;
+
+    // Cancellations so far, and those seen by the last start() or on construction
+    std::atomic<quint64> m_Cancellations;
+    quint64 m_Started = 0;
+
+    const ArithmBudget *m_Parent = nullptr;
+    quint64 m_ParentStarted = 0;
+};
@@ -0,0 +1,68 @@
+#include "arithm_cache.h"
+#include "arithm_library.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+
+void ArithmCache::SetDirectory(const QString &directory, int capacity)
+{
+    m_Directory = directory;
+    m_Capacity = qMax(capacity, 0);
+    QDir().mkpath(m_Directory);
+
+    Prune();
+}
+
+void ArithmCache::SetSignature(const QString &signature)
+{
+    m_Signature = signature;
+}
+
+bool ArithmCache::Load(const QString &expression, exprtk::token_program &program) const
+{
+    if(m_Directory.isEmpty())
+        return false;
+
+    // Entries are replaced by rename, so a mapped file is never seen half written
+    if(!ArithmLibrary::Read(FileName(expression), program))
+        return false;
+
+    return program.expression() == expression.toStdString();
+}
+
+bool ArithmCache::Store(const exprtk::token_program &program) const
+{
+    if(m_Directory.isEmpty() || program.empty())
+        return false;
+
+    if(!ArithmLibrary::Write(FileName(QString::fromStdString(program.expression())), program))
+        return false;
+
+    // Some slack, so the directory is not listed on every store once full
+    if(++m_Count > m_Capacity + m_Capacity / 8)
+        Prune();
+
+    return true;
+}
+
+QString ArithmCache::FileName(const QString &expression) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(m_Signature.toUtf8());
+    hash.addData("\0", 1);
+    hash.addData(expression.toUtf8());
+
+    return m_Directory + "/" + QString::fromLatin1(hash.result().toHex()) + ".prg";
+}
+
+void ArithmCache::Prune()
+{
+    // Recalled entries are stored again with the history, so the oldest ones are no longer
+    // recorded, including entries of other versions that no signature matches anymore
+    const QFileInfoList entries = QDir(m_Directory).entryInfoList(QStringList() << "*.prg", QDir::Files, QDir::Time);
+
+    for(int i = m_Capacity; i < entries.size(); i++)
+        QFile::remove(entries[i].absoluteFilePath());
+
+    m_Count = qMin(entries.size(), m_Capacity);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QString>
+
+#include "exprtk.hpp"
+
+// Content-addressed token programs on disk, shared by all Arithm instances
+class ArithmCache
+{
+public:
+    // At most capacity entries are kept, like the history they belong to
+    void SetDirectory(const QString &directory, int capacity);
+    void SetSignature(const QString &signature);
+
+    bool Load(const QString &expression, exprtk::token_program &program) const;
+    bool Store(const exprtk::token_program &program);
+
+private:
+    QString FileName(const QString &expression) const;
+    void Prune();
+
+private:
+    QString m_Directory;
+    QString m_Signature;
+
+    int m_Capacity = 0;
+    int m_Count = 0;
+};
@@ -0,0 +1,661 @@
+#include "arithm_dataset.h"
+#include "arithm_budget.h"
+#include "arithm_optimizer.h"
+#include "arithm_task.h"
+#include "settings.h"
+
+#include <QFile>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+class ArithmDataset::Reader
+{
+public:
+    virtual ~Reader() {}
+
+    virtual bool Open(const QString &path, std::vector<std::string> &columns, QString &error) = 0;
+
+    // Fills up to DATA_BLOCK_ROWS rows, returns 0 at the end and -1 on errors
+    virtual int Read(Block &block, QString &error) = 0;
+};
+
+class ArithmDataset::Writer
+{
+public:
+    virtual ~Writer() {}
+
+    virtual bool Open(const QString &path, const std::vector<std::string> &columns, QString &error) = 0;
+    virtual bool Write(const Block &block, QString &error) = 0;
+    virtual bool Close(QString &error) = 0;
+};
+
+// Plain numeric CSV, read line by line, empty and non-numeric fields become NaN
+class ArithmDataset::CsvReader : public ArithmDataset::Reader
+{
+public:
+    bool Open(const QString &path, std::vector<std::string> &columns, QString &error) override
+    {
+        m_File.setFileName(path);
+
+        if(!m_File.open(QIODevice::ReadOnly))
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        const QByteArray header = m_File.readLine().trimmed();
+        if(header.isEmpty())
+        {
+            error = "Missing header row";
+            return false;
+        }
+
+        for(QByteArray name : header.split(','))
+        {
+            name = name.trimmed();
+            if(name.size() > 1 && name.startsWith('"') && name.endsWith('"'))
+                name = name.mid(1, name.size() - 2);
+
+            columns.push_back(name.toStdString());
+        }
+
+        m_Columns = int(columns.size());
+        return true;
+    }
+
+    int Read(Block &block, QString &error) override
+    {
+        int rows = 0;
+
+        while(rows < DATA_BLOCK_ROWS && !m_File.atEnd())
+        {
+            const QByteArray line = m_File.readLine();
+            if(line.trimmed().isEmpty())
+                continue;
+
+            const char *field = line.constData();
+            const char *end = field + line.size();
+
+            for(int column = 0; column < m_Columns; column++)
+            {
+                const char *comma = static_cast<const char*>(std::memchr(field, ',', std::size_t(end - field)));
+                const char *stop = comma ? comma : end;
+
+                bool isNumber = false;
+                const double value = QByteArray::fromRawData(field, int(stop - field)).trimmed().toDouble(&isNumber);
+
+                block.inputs[std::size_t(column) * DATA_BLOCK_ROWS + rows] = isNumber ? value : std::nan("1");
+                field = comma ? comma + 1 : end;
+            }
+
+            rows++;
+        }
+
+        if(m_File.error() != QFileDevice::NoError)
+        {
+            error = m_File.errorString();
+            return -1;
+        }
+
+        return rows;
+    }
+
+private:
+    QFile m_File;
+    int m_Columns = 0;
+};
+
+// Blocked columnar layout, see ColumnWriter. Each block is copied out of a
+// mapping of just its rows, so only a window of the file is mapped at a time
+class ArithmDataset::ColumnReader : public ArithmDataset::Reader
+{
+public:
+    bool Open(const QString &path, std::vector<std::string> &columns, QString &error) override
+    {
+        m_File.setFileName(path);
+
+        if(!m_File.open(QIODevice::ReadOnly))
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        char magic[4];
+        quint32 version = 0;
+        quint32 count = 0;
+
+        if(m_File.read(magic, sizeof(magic)) != sizeof(magic) || std::memcmp(magic, DATA_COLUMN_MAGIC, sizeof(magic)) != 0 ||
+           !ReadValue(version) || version != DATA_COLUMN_VERSION || !ReadValue(count) || count == 0)
+        {
+            error = "Not a columnar data file";
+            return false;
+        }
+
+        for(quint32 i = 0; i < count; i++)
+        {
+            quint32 length = 0;
+            QByteArray name;
+
+            if(ReadValue(length))
+                name = m_File.read(length);
+
+            if(name.size() != int(length) || name.isEmpty())
+            {
+                error = "Truncated column names";
+                return false;
+            }
+
+            columns.push_back(name.toStdString());
+        }
+
+        m_Columns = count;
+        m_Next = m_File.pos();
+        return true;
+    }
+
+    int Read(Block &block, QString &error) override
+    {
+        // Skip to the next stored block once this one is used up
+        while(m_Done == m_Rows)
+        {
+            if(m_Next >= m_File.size())
+                return 0;
+
+            quint64 rows = 0;
+            if(!m_File.seek(m_Next) || !ReadValue(rows))
+            {
+                error = "Truncated block header";
+                return -1;
+            }
+
+            m_Start = m_Next + qint64(sizeof(rows));
+            m_Rows = rows;
+            m_Done = 0;
+            m_Next = m_Start + qint64(rows * m_Columns * sizeof(double));
+
+            if(m_Next > m_File.size())
+            {
+                error = "Truncated block";
+                return -1;
+            }
+        }
+
+        const int rows = int(std::min<quint64>(m_Rows - m_Done, DATA_BLOCK_ROWS));
+        const qint64 size = qint64(rows * sizeof(double));
+
+        for(quint32 column = 0; column < m_Columns; column++)
+        {
+            uchar *data = m_File.map(m_Start + qint64((column * m_Rows + m_Done) * sizeof(double)), size);
+            if(!data)
+            {
+                error = m_File.errorString();
+                return -1;
+            }
+
+            std::memcpy(&block.inputs[std::size_t(column) * DATA_BLOCK_ROWS], data, std::size_t(size));
+            m_File.unmap(data);
+        }
+
+        m_Done += quint64(rows);
+        return rows;
+    }
+
+private:
+    template<typename T>
+    bool ReadValue(T &value)
+    {
+        return m_File.read(reinterpret_cast<char*>(&value), sizeof(T)) == qint64(sizeof(T));
+    }
+
+private:
+    QFile m_File;
+    quint32 m_Columns = 0;
+
+    // Current stored block and the offset of the next one
+    qint64 m_Start = 0;
+    quint64 m_Rows = 0;
+    quint64 m_Done = 0;
+    qint64 m_Next = 0;
+};
+
+class ArithmDataset::CsvWriter : public ArithmDataset::Writer
+{
+public:
+    bool Open(const QString &path, const std::vector<std::string> &columns, QString &error) override
+    {
+        m_File.setFileName(path);
+
+        if(!m_File.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        QByteArray header;
+        for(std::size_t i = 0; i < columns.size(); i++)
+        {
+            if(i > 0)
+                header += ',';
+            header += QByteArray::fromStdString(columns[i]);
+        }
+        header += '\n';
+
+        m_Columns = columns.size();
+        return Flush(header, error);
+    }
+
+    bool Write(const Block &block, QString &error) override
+    {
+        // One write per block, the buffer keeps its capacity
+        m_Buffer.resize(0);
+
+        for(int row = 0; row < block.rows; row++)
+        {
+            for(std::size_t column = 0; column < m_Columns; column++)
+            {
+                if(column > 0)
+                    m_Buffer += ',';
+                m_Buffer += QByteArray::number(block.outputs[column * DATA_BLOCK_ROWS + std::size_t(row)], 'g', 17);
+            }
+            m_Buffer += '\n';
+        }
+
+        return Flush(m_Buffer, error);
+    }
+
+    bool Close(QString &error) override
+    {
+        if(!m_File.flush())
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        m_File.close();
+        return true;
+    }
+
+private:
+    bool Flush(const QByteArray &data, QString &error)
+    {
+        if(m_File.write(data) == data.size())
+            return true;
+
+        error = m_File.errorString();
+        return false;
+    }
+
+private:
+    QFile m_File;
+    QByteArray m_Buffer;
+    std::size_t m_Columns = 0;
+};
+
+// Magic, version, column count and length-prefixed names, followed by blocks of
+// a row count and that many native doubles per column, column after column
+class ArithmDataset::ColumnWriter : public ArithmDataset::Writer
+{
+public:
+    bool Open(const QString &path, const std::vector<std::string> &columns, QString &error) override
+    {
+        m_File.setFileName(path);
+
+        if(!m_File.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        const quint32 version = DATA_COLUMN_VERSION;
+        const quint32 count = quint32(columns.size());
+
+        bool isWritten = WriteData(DATA_COLUMN_MAGIC, 4) && WriteData(&version, sizeof(version)) && WriteData(&count, sizeof(count));
+
+        for(const std::string &name : columns)
+        {
+            const quint32 length = quint32(name.size());
+            isWritten = isWritten && WriteData(&length, sizeof(length)) && WriteData(name.data(), name.size());
+        }
+
+        if(!isWritten)
+            error = m_File.errorString();
+
+        m_Columns = columns.size();
+        return isWritten;
+    }
+
+    bool Write(const Block &block, QString &error) override
+    {
+        const quint64 rows = quint64(block.rows);
+        bool isWritten = WriteData(&rows, sizeof(rows));
+
+        for(std::size_t column = 0; column < m_Columns && isWritten; column++)
+            isWritten = WriteData(&block.outputs[column * DATA_BLOCK_ROWS], std::size_t(block.rows) * sizeof(double));
+
+        if(!isWritten)
+            error = m_File.errorString();
+
+        return isWritten;
+    }
+
+    bool Close(QString &error) override
+    {
+        if(!m_File.flush())
+        {
+            error = m_File.errorString();
+            return false;
+        }
+
+        m_File.close();
+        return true;
+    }
+
+private:
+    bool WriteData(const void *data, std::size_t size)
+    {
+        return m_File.write(static_cast<const char*>(data), qint64(size)) == qint64(size);
+    }
+
+private:
+    QFile m_File;
+    std::size_t m_Columns = 0;
+};
+
+ArithmDataset::ArithmDataset()
+{
+}
+
+ArithmDataset::~ArithmDataset()
+{
+    m_Pool.waitForDone();
+}
+
+void ArithmDataset::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+QString ArithmDataset::Error() const
+{
+    return m_Error;
+}
+
+qint64 ArithmDataset::Evaluate(const QString &expression, const QString &input, const QString &output)
+{
+    m_Free.clear();
+    m_Read.clear();
+    m_Done.clear();
+    m_Count = -1;
+    m_isFailed = false;
+    m_Error.clear();
+
+    std::unique_ptr<Reader> reader;
+    if(input.endsWith(".csv", Qt::CaseInsensitive))
+        reader.reset(new CsvReader);
+    else
+        reader.reset(new ColumnReader);
+
+    std::vector<std::string> columns;
+    if(!reader->Open(input, columns, m_Error) || !Compile(expression, columns))
+        return -1;
+
+    std::vector<std::string> names;
+    for(const std::string &name : m_Outputs)
+        names.push_back(name.empty() ? "result" : name);
+
+    std::unique_ptr<Writer> writer;
+    if(output.endsWith(".csv", Qt::CaseInsensitive))
+        writer.reset(new CsvWriter);
+    else
+        writer.reset(new ColumnWriter);
+
+    if(!writer->Open(output, names, m_Error))
+        return -1;
+
+    // One reader and the evaluators run on the pool, this thread writes
+    const int workers = qMax(1, QThread::idealThreadCount() - 1);
+    m_Pool.setMaxThreadCount(workers + 1);
+
+    m_Blocks.resize(std::size_t(DATA_BLOCKS_PER_THREAD * (workers + 1)));
+    for(std::unique_ptr<Block> &block : m_Blocks)
+    {
+        if(!block)
+            block.reset(new Block);
+
+        block->inputs.resize(m_Columns.size() * DATA_BLOCK_ROWS);
+        block->outputs.resize(m_Outputs.size() * DATA_BLOCK_ROWS);
+        m_Free.enqueue(block.get());
+    }
+
+    Reader *source = reader.get();
+    m_Pool.start(new ArithmTask([this, source]() { Read(*source); }));
+
+    for(int i = 0; i < workers; i++)
+        m_Pool.start(new ArithmTask([this]() { Work(); }));
+
+    // Blocks are evaluated out of order but written in sequence
+    qint64 rows = 0;
+    for(qint64 sequence = 0; ; sequence++)
+    {
+        Block *block = nullptr;
+
+        {
+            QMutexLocker locker(&m_Mutex);
+
+            while(!m_Done.contains(sequence) && (m_Count < 0 || sequence < m_Count) && !m_isFailed)
+                m_Changed.wait(&m_Mutex);
+
+            if(m_isFailed || !m_Done.contains(sequence))
+                break;
+
+            block = m_Done.take(sequence);
+        }
+
+        QString error;
+        if(!writer->Write(*block, error))
+        {
+            Fail(error);
+            break;
+        }
+
+        rows += block->rows;
+
+        QMutexLocker locker(&m_Mutex);
+        m_Free.enqueue(block);
+        m_Changed.wakeAll();
+    }
+
+    m_Pool.waitForDone();
+
+    if(m_isFailed || !writer->Close(m_Error))
+        return -1;
+
+    return rows;
+}
+
+bool ArithmDataset::Compile(const QString &expression, const std::vector<std::string> &columns)
+{
+    // Parsed against placeholders, the evaluators bind their own storage
+    std::vector<arithm_double> storage(columns.size());
+
+    exprtk::symbol_table<arithm_double> symbols;
+    for(std::size_t i = 0; i < columns.size(); i++)
+    {
+        if(!symbols.add_variable(columns[i], storage[i]))
+        {
+            m_Error = QString("Invalid column name '%1'").arg(QString::fromStdString(columns[i]));
+            return false;
+        }
+    }
+    symbols.add_constants();
+
+    ArithmOptimizer optimizer(symbols);
+
+    exprtk::expression<arithm_double> compiled;
+    compiled.register_symbol_table(symbols);
+
+    // Unknown names become the output columns
+    ArithmBudget budget;
+    exprtk::parser<arithm_double> parser;
+    parser.register_loop_runtime_check(budget);
+    parser.enable_unknown_symbol_resolver();
+
+    if(!parser.compile(expression.toStdString(), compiled, m_Program))
+    {
+        m_Error = QString::fromStdString(parser.error());
+        return false;
+    }
+
+    std::vector<std::string> variables;
+    symbols.get_variable_list(variables);
+
+    m_Columns = columns;
+    m_Outputs.clear();
+
+    for(const std::string &name : variables)
+    {
+        if(std::find(columns.begin(), columns.end(), name) == columns.end() && !symbols.is_constant_node(name))
+            m_Outputs.push_back(name);
+    }
+
+    m_Variables = columns;
+    m_Variables.insert(m_Variables.end(), m_Outputs.begin(), m_Outputs.end());
+
+    // An empty name stands for the result
+    if(m_Outputs.empty())
+        m_Outputs.push_back("");
+
+    return true;
+}
+
+void ArithmDataset::Read(Reader &reader)
+{
+    for(qint64 sequence = 0; ; sequence++)
+    {
+        Block *block = nullptr;
+
+        {
+            QMutexLocker locker(&m_Mutex);
+
+            while(m_Free.isEmpty() && !m_isFailed)
+                m_Changed.wait(&m_Mutex);
+
+            if(m_isFailed)
+                return;
+
+            block = m_Free.dequeue();
+        }
+
+        QString error;
+        const int rows = reader.Read(*block, error);
+
+        QMutexLocker locker(&m_Mutex);
+
+        if(rows <= 0)
+        {
+            if(rows < 0 && !m_isFailed)
+            {
+                m_isFailed = true;
+                m_Error = error;
+            }
+
+            m_Free.enqueue(block);
+            m_Count = sequence;
+            m_Changed.wakeAll();
+            return;
+        }
+
+        block->sequence = sequence;
+        block->rows = rows;
+
+        m_Read.enqueue(block);
+        m_Changed.wakeAll();
+    }
+}
+
+void ArithmDataset::Work()
+{
+    ArithmBudget budget(m_Budget);
+
+    ArithmEvaluator evaluator(m_Program, m_Variables, &budget);
+
+    if(!evaluator.IsValid())
+    {
+        Fail("Expression does not compile");
+        return;
+    }
+
+    std::vector<arithm_double*> inputs;
+    for(const std::string &name : m_Columns)
+        inputs.push_back(evaluator.Variable(name));
+
+    std::vector<arithm_double*> outputs;
+    for(const std::string &name : m_Outputs)
+        outputs.push_back(name.empty() ? nullptr : evaluator.Variable(name));
+
+    for(;;)
+    {
+        Block *block = nullptr;
+
+        {
+            QMutexLocker locker(&m_Mutex);
+
+            while(m_Read.isEmpty() && m_Count < 0 && !m_isFailed)
+                m_Changed.wait(&m_Mutex);
+
+            if(m_Read.isEmpty() || m_isFailed)
+                return;
+
+            block = m_Read.dequeue();
+        }
+
+        budget.start();
+
+        try
+        {
+            for(int row = 0; row < block->rows; row++)
+            {
+                budget.checkpoint();
+
+                for(std::size_t column = 0; column < inputs.size(); column++)
+                    *inputs[column] = block->inputs[column * DATA_BLOCK_ROWS + std::size_t(row)];
+
+                // Rows are evaluated in any order, so nothing may carry over
+                for(arithm_double *output : outputs)
+                {
+                    if(output)
+                        *output = std::nanl("1");
+                }
+
+                const arithm_double result = evaluator.Value();
+
+                for(std::size_t column = 0; column < outputs.size(); column++)
+                    block->outputs[column * DATA_BLOCK_ROWS + std::size_t(row)] = double(outputs[column] ? *outputs[column] : result);
+            }
+        }
+        catch(const std::runtime_error &error)
+        {
+            Fail(QString::fromStdString(error.what()));
+            return;
+        }
+
+        QMutexLocker locker(&m_Mutex);
+        m_Done.insert(block->sequence, block);
+        m_Changed.wakeAll();
+    }
+}
+
+void ArithmDataset::Fail(const QString &error)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    if(!m_isFailed)
+    {
+        m_isFailed = true;
+        m_Error = error;
+    }
+
+    m_Changed.wakeAll();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arithm_evaluator.h"
+
+// Evaluates an expression over the rows of a data file, with reading, evaluating
+// and writing pipelined across threads on a fixed number of row blocks
+class ArithmDataset
+{
+public:
+    ArithmDataset();
+    ~ArithmDataset();
+
+    void SetBudget(const ArithmBudget *budget);
+
+    // Files ending in .csv are read and written as CSV with a header row, others as
+    // blocked columnar files. Columns bind to variables of the same name, variables
+    // assigned by the expression become the output columns, otherwise its result.
+    // Returns the number of rows written, -1 on errors
+    qint64 Evaluate(const QString &expression, const QString &input, const QString &output);
+
+    QString Error() const;
+
+private:
+    class Reader;
+    class CsvReader;
+    class ColumnReader;
+
+    class Writer;
+    class CsvWriter;
+    class ColumnWriter;
+
+    struct Block
+    {
+        qint64 sequence = 0;
+        int rows = 0;
+
+        // Column-major, DATA_BLOCK_ROWS apart
+        std::vector<double> inputs;
+        std::vector<double> outputs;
+    };
+
+    bool Compile(const QString &expression, const std::vector<std::string> &columns);
+
+    void Read(Reader &reader);
+    void Work();
+    void Fail(const QString &error);
+
+private:
+    QThreadPool m_Pool;
+
+    QMutex m_Mutex;
+    QWaitCondition m_Changed;
+
+    // Blocks cycle from free to read to done and back, so memory stays constant
+    std::vector<std::unique_ptr<Block>> m_Blocks;
+    QQueue<Block*> m_Free;
+    QQueue<Block*> m_Read;
+    QMap<qint64, Block*> m_Done;
+
+    qint64 m_Count = -1;
+    bool m_isFailed = false;
+    QString m_Error;
+
+    exprtk::token_program m_Program;
+    std::vector<std::string> m_Variables;
+    std::vector<std::string> m_Columns;
+    std::vector<std::string> m_Outputs;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -1,19 +1,71 @@
 #include "arithm_dialog.h"
 #include "ui_arithm_dialog.h"
+#include "arithm_split.h"
+
+#include <QCompleter>
+#include <QMouseEvent>
+#include <QFile>
+#include <QFileInfo>
+#include <QLegendMarker>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
 
 ArithmDialog::ArithmDialog(QWidget *parent)
-    : QDialog(parent), ui(new Ui::Dialog), m_Chart(new QChart()),
+    : QDialog(parent), ui(new Ui::Dialog), m_Optimizer(m_Symbols, &m_Budget), m_Chart(new QChart()),
       m_Settings(new QSettings("Arithm.ini", QSettings::IniFormat))
 {
     ui->setupUi(this);
     setWindowFlags(Qt::Window);
 
+    // QtCharts or the lightweight QPainter renderer
+    if(m_Settings->value(PLOT_RENDERER_KEY, PLOT_RENDERER_DEFAULT).toInt() == PLOT_RENDERER_PAINTER)
+    {
+        m_Plot = new ArithmPlot(this);
+        ui->chart->parentWidget()->layout()->replaceWidget(ui->chart, m_Plot);
+        ui->chart->hide();
+    }
+
+    // Drag to pan over either renderer
+    if(m_Plot)
+        m_Plot->installEventFilter(this);
+    else
+        ui->chart->viewport()->installEventFilter(this);
+
+    connect(&m_Tiles, &ArithmTiles::TileReady, this, [this](quint64 generation) { if(generation == m_Tiles.Generation()) Pan(); });
+    connect(&m_Field, &ArithmField::TileReady, this, [this]() { if(m_isField) ShowField(); });
+
     // Plot theme
     m_ChartTheme = QChart::ChartTheme(m_Settings->value(PLOT_THEME_KEY, PLOT_THEME_DEFAULT).toInt());
 
     // Read default visualization parameters
     m_Samples = m_Settings->value(PLOT_SAMPLES_KEY, PLOT_SAMPLES_DEFAULT).toInt();
     m_HistoryCount = m_Settings->value(HISTORY_COUNT_KEY, HISTORY_COUNT_DEFAULT).toInt();
+    m_History.SetFileName(QFileInfo(m_Settings->fileName()).absolutePath() + "/" + HISTORY_JOURNAL_FILE);
+
+    // One journal record per evaluated input, once typing has settled
+    m_HistoryTimer.setSingleShot(true);
+    m_HistoryTimer.setInterval(HISTORY_RECORD_DELAY);
+    connect(&m_HistoryTimer, &QTimer::timeout, this, &ArithmDialog::SaveHistory);
+
+    // Bound loop iterations and evaluation time to keep the input responsive
+    m_Budget.setMaxIterations(m_Settings->value(RUNTIME_MAX_ITERATIONS_KEY, RUNTIME_MAX_ITERATIONS_DEFAULT).toULongLong());
+    m_Budget.setTimeout(m_Settings->value(RUNTIME_TIMEOUT_KEY, RUNTIME_TIMEOUT_DEFAULT).toLongLong());
+    m_Parser.register_loop_runtime_check(m_Budget);
+
+    m_Tiles.SetBudget(&m_Budget);
+    m_Field.SetBudget(&m_Budget);
+    m_Sweep.SetBudget(&m_Budget);
+
+    m_FieldResolution = qMax(1, m_Settings->value(PLOT_FIELD_RESOLUTION_KEY, PLOT_FIELD_RESOLUTION_DEFAULT).toInt());
+    m_FieldContours = m_Settings->value(PLOT_FIELD_CONTOURS_KEY, PLOT_FIELD_CONTOURS_DEFAULT).toInt();
+
+    // Per statement evaluation cost, shown as output tooltip
+    if(m_Settings->value(RUNTIME_PROFILE_KEY, RUNTIME_PROFILE_DEFAULT).toInt() != 0)
+        m_Parser.settings().enable_profiling();
+
+    // Pre-built token programs skip lexing for known formulas
+    m_Library.Load(m_Settings->value(RUNTIME_LIBRARY_KEY, RUNTIME_LIBRARY_DEFAULT).toString());
 
     ResetSymbols();
 
@@ -26,10 +78,28 @@ ArithmDialog::ArithmDialog(QWidget *parent)
     // Independent variable
     m_Symbols.add_variable("x", m_X);
 
-    // Dependent variables
-    m_Symbols.add_variable("f", m_F);
-    m_Symbols.add_variable("g", m_G);
-    m_Symbols.add_variable("h", m_H);
+    // Second independent variable of z = f(x, y) fields
+    m_Symbols.add_variable("y", m_Y);
+
+    // Dependent variables, f, g and h followed by f1..fN
+    m_CurveNames = { "f", "g", "h" };
+    for(int i = 1; i <= PLOT_NUMBERED_CURVES; i++)
+        m_CurveNames.push_back("f" + std::to_string(i));
+
+    // Sized once, the symbol table keeps references into it
+    m_CurveValues.assign(m_CurveNames.size(), std::nanl("1"));
+    for(std::size_t i = 0; i < m_CurveNames.size(); i++)
+        m_Symbols.add_variable(m_CurveNames[i], m_CurveValues[i]);
+
+    // Implicit curves F(x, y) = 0 are given as z := F(x, y)
+    m_Symbols.add_variable("z", m_Z);
+
+    // Parametric (f(t), g(t)) and polar r(t) curves
+    m_Symbols.add_variable("t", m_T);
+    m_Symbols.add_variable("r", m_R);
+
+    // Swept parameter of curve families
+    m_Symbols.add_variable("k", m_K);
 
     // Constraints
     m_Symbols.add_variable("x_min", m_X_Min);
@@ -38,9 +108,30 @@ ArithmDialog::ArithmDialog(QWidget *parent)
     m_Symbols.add_variable("y_min", m_Y_Min);
     m_Symbols.add_variable("y_max", m_Y_Max);
 
+    m_Symbols.add_variable("t_min", m_T_Min);
+    m_Symbols.add_variable("t_max", m_T_Max);
+
+    m_Symbols.add_variable("k_min", m_K_Min);
+    m_Symbols.add_variable("k_max", m_K_Max);
+    m_Symbols.add_variable("k_step", m_K_Step);
+
     m_Symbols.add_constants();
     m_Expression.register_symbol_table(m_Symbols);
 
+    ResetCache();
+
+    // History backed by a lazy model, completed through the history index
+    m_HistoryModel = new ArithmHistoryModel(this);
+    ui->input->setModel(m_HistoryModel);
+    ui->input->setInsertPolicy(QComboBox::NoInsert);
+
+    m_CompletionModel = new ArithmHistoryModel(this);
+    QCompleter *completer = new QCompleter(m_CompletionModel, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    ui->input->setCompleter(completer);
+
+    connect(ui->input->lineEdit(), &QLineEdit::textEdited, this, &ArithmDialog::CompleteHistory);
+
     // Set focus to input so we can start right away
     ui->input->setFocus();
 
@@ -50,6 +141,7 @@ ArithmDialog::ArithmDialog(QWidget *parent)
 
 ArithmDialog::~ArithmDialog()
 {
+    m_Precompiler.Cancel();
     m_Chart->removeAllSeries();
 
     SaveHistory();
@@ -60,8 +152,165 @@ ArithmDialog::~ArithmDialog()
     delete ui;
 }
 
+void ArithmDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+
+    // Queue behind the first paint so startup is never delayed
+    if(!m_isPrecompiled)
+    {
+        m_isPrecompiled = true;
+        QTimer::singleShot(0, this, &ArithmDialog::PrecompileHistory);
+    }
+}
+
+bool ArithmDialog::eventFilter(QObject *object, QEvent *event)
+{
+    if(!m_isPlotted || m_isParametric || m_isPolar || m_isSweep)
+        return QDialog::eventFilter(object, event);
+
+    if(event->type() == QEvent::MouseButtonPress)
+    {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+        if(mouse->button() == Qt::LeftButton)
+        {
+            // Keep zoom level and vertical range while dragging
+            m_GridGeneration++;
+            m_isPanning = true;
+            m_PanOrigin = mouse->pos();
+            m_PanRange = arithm_pair(m_X_Min, m_X_Max);
+            m_PanTileWidth = double(m_X_Max - m_X_Min) / PLOT_TILES;
+
+            // Tiles within the complete grid are taken from it instead of sampled again
+            if(m_GridStride == 1)
+            {
+                const qint64 first = qint64(std::ceil(double(m_X_Min) / m_PanTileWidth));
+                const qint64 last = qint64(std::floor(double(m_X_Max) / m_PanTileWidth)) - 1;
+
+                for(qint64 index = first; index <= last; index++)
+                    m_Tiles.Insert(m_PanTileWidth, index, GridTile(index * m_PanTileWidth, (index + 1) * m_PanTileWidth));
+            }
+
+            m_Y_Min = m_YRange.first;
+            m_Y_Max = m_YRange.second;
+
+            return true;
+        }
+    }
+    else if(event->type() == QEvent::MouseMove && m_isPanning)
+    {
+        QMouseEvent *mouse = static_cast<QMouseEvent*>(event);
+
+        const int width = m_Plot ? m_Plot->PlotArea().width() : int(m_Chart->plotArea().width());
+        if(width > 0)
+        {
+            const arithm_double delta = (m_PanOrigin.x() - mouse->pos().x()) * (m_PanRange.second - m_PanRange.first) / width;
+
+            m_X_Min = m_PanRange.first + delta;
+            m_X_Max = m_PanRange.second + delta;
+
+            Pan();
+        }
+
+        return true;
+    }
+    else if(event->type() == QEvent::MouseButtonRelease && m_isPanning)
+    {
+        m_isPanning = false;
+        return true;
+    }
+
+    return QDialog::eventFilter(object, event);
+}
+
+void ArithmDialog::Pan()
+{
+    if(!m_isPlotted || m_PanTileWidth <= 0)
+        return;
+
+    const double width = m_PanTileWidth;
+    const qint64 first = qint64(std::floor(double(m_X_Min) / width));
+    const qint64 last = qint64(std::floor(double(m_X_Max) / width));
+
+    QVector<QVector<QPointF>> curves(m_Active.size());
+    arithm_pair minMax(std::nanl("1"), std::nanl("1"));
+
+    for(qint64 index = first; index <= last; index++)
+    {
+        ArithmTile tile;
+        if(!m_Tiles.Find(width, index, tile))
+        {
+            m_Tiles.Request(width, index);
+
+            // Show the samples from before the drag until the tile arrives
+            tile = GridTile(index * width, (index + 1) * width);
+        }
+
+        for(int i = 0; i < curves.size() && i < tile.curves.size(); i++)
+            curves[i] += tile.curves[i];
+    }
+
+    // Prefetch the neighbours that scroll into view next
+    m_Tiles.Request(width, first - 1);
+    m_Tiles.Request(width, last + 1);
+
+    // Tiles come split, so dragging evaluates nothing on this thread
+    ShowCurves(curves, minMax);
+
+    ui->output->setText(QString::fromUtf8("Results for %1 ≤ x ≤ %2").arg(double(m_X_Min)).arg(double(m_X_Max)));
+}
+
+ArithmTile ArithmDialog::GridTile(double a, double b) const
+{
+    ArithmTile tile;
+    tile.curves.resize(m_Active.size());
+
+    // Split samples of the last pass within [a, b), like a sampled tile
+    for(int j = 0; j < tile.curves.size() && j < m_GridCurves.size(); j++)
+    {
+        for(const QPointF &point : m_GridCurves[j])
+        {
+            if(point.x() >= a && point.x() < b)
+                tile.curves[j].append(point);
+        }
+    }
+
+    return tile;
+}
+
+void ArithmDialog::ResetTiles()
+{
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+
+    // Same order as the curves in ShowCurves, lazy plots use the result
+    std::vector<std::string> curves;
+    for(int slot : m_Active)
+        curves.push_back(slot < 0 ? "" : m_CurveNames[slot]);
+
+    m_Tiles.Reset(m_Program, variables, curves, m_Samples / PLOT_TILES);
+    m_PanTileWidth = 0;
+}
+
 void ArithmDialog::wheelEvent(QWheelEvent *event)
 {
+    // Ctrl scrubs through the members of a family, past either end shows all of them
+    if(m_isSweep && (event->modifiers() & Qt::ControlModifier))
+    {
+        const int count = m_SweepValues.size();
+        const int step = event->angleDelta().y() < 0 ? -1 : 1;
+
+        m_SweepFrame = m_SweepFrame < 0 ? (step > 0 ? 0 : count - 1) : m_SweepFrame + step;
+        if(m_SweepFrame >= count)
+            m_SweepFrame = -1;
+
+        // Members not cached yet are sampled within a new evaluation budget
+        m_Budget.start();
+
+        ShowSweep();
+        return;
+    }
+
     arithm_double newRange;
 
     if(event->pixelDelta().y() < 0)
@@ -81,64 +330,84 @@ void ArithmDialog::wheelEvent(QWheelEvent *event)
 
 void ArithmDialog::LoadHistory()
 {
-    m_Settings->sync();
-
-    ui->input->clear();
+    QVector<ArithmHistoryEntry> entries;
     if(m_Settings->value(HISTORY_SAVE_KEY, HISTORY_SAVE_DEFAULT).toInt() != 0)
     {
-        for (int i = 0; i < m_HistoryCount; i++)
+        // Carry over entries of the former History/Entry_N keys once
+        if(!m_History.Exists())
         {
-            QString item = QString(m_Settings->value(QString(HISTORY_ENTRY_KEY) + QString::number(i), "").toString());
-            if(!item.isEmpty())
+            QStringList entries;
+            for (int i = 0; i < m_HistoryCount; i++)
             {
-                ui->input->addItem(item);
+                QString item = m_Settings->value(QString(HISTORY_ENTRY_KEY) + QString::number(i), "").toString();
+                if(!item.isEmpty())
+                    entries << item;
             }
+
+            if(!entries.isEmpty())
+                m_History.Import(entries);
         }
+
+        entries = m_History.Load(m_HistoryCount);
     }
 
+    // The combo box model only materialises rows as the popup scrolls
+    QStringList items;
+    for(const ArithmHistoryEntry &entry : entries)
+        items << entry.expression;
+
+    m_HistoryIndex.SetEntries(entries);
+    m_HistoryModel->SetItems(items);
+
     ui->input->lineEdit()->clear();
 }
 
+void ArithmDialog::CompleteHistory(const QString &text)
+{
+    m_CompletionModel->SetItems(m_HistoryIndex.Match(text, HISTORY_COMPLETION_LIMIT));
+
+    if(m_CompletionModel->rowCount() > 0)
+        ui->input->completer()->complete();
+}
+
 void ArithmDialog::SaveHistory()
 {
-    m_Settings->sync();
+    m_HistoryTimer.stop();
+
+    const QString entry = m_PendingEntry;
+    m_PendingEntry.clear();
 
-    if(m_Settings->value(HISTORY_SAVE_KEY, HISTORY_SAVE_DEFAULT).toInt() != 0 &&
-            !ui->input->lineEdit()->text().isEmpty())
+    if(m_Settings->value(HISTORY_SAVE_KEY, HISTORY_SAVE_DEFAULT).toInt() != 0 && !entry.isEmpty())
     {
-        // Allow multiple instances without losing history entries
-        QString currentEntry = ui->input->lineEdit()->text();
-        LoadHistory();
+        if(!m_Program.empty() && m_Program.expression() == entry.toStdString())
+            m_Cache.Store(m_Program);
 
-        bool bFound = false;
-        for (int i = 0; i < m_HistoryCount; i++)
-        {
-            if(ui->input->itemText(i) == currentEntry)
-                bFound = true;
-        }
+        // Concurrent instances append their own records, merged on load
+        m_History.Append(entry);
+    }
+}
 
-        if (bFound == false)
-        {
-            m_Settings->setValue(QString(HISTORY_ENTRY_KEY + QString::number(0)), currentEntry);
+void ArithmDialog::PrecompileHistory()
+{
+    const QVector<ArithmHistoryEntry> &entries = m_HistoryIndex.Entries();
+    const int count = qMin(entries.size(), m_Settings->value(HISTORY_PRECOMPILE_KEY, HISTORY_PRECOMPILE_DEFAULT).toInt());
 
-            // Remaining KEY_HISTORY_COUNT-1 items (last item will be discarded)
-            for(int i = 0; i < m_HistoryCount-1; i++)
-            {
-                QString item = ui->input->itemText(i);
-                if(!item.isEmpty())
-                {
-                    m_Settings->setValue(QString(HISTORY_ENTRY_KEY + QString::number(i+1)), item);
-                }
-            }
-        }
-    }
+    QStringList expressions;
+    for(int i = 0; i < count; i++)
+        expressions << entries[i].expression;
+
+    if(expressions.isEmpty())
+        return;
 
-    m_Settings->sync();
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+
+    m_Precompiler.Start(expressions, variables, m_Cache);
 }
 
-void ArithmDialog::AddPair(QLineSeries *series, const arithm_double x, const arithm_double y, arithm_pair *minMax)
+void ArithmDialog::AddSample(double *sample, const arithm_double y, arithm_pair *minMax)
 {
-    series->append(x, y);
+    *sample = double(y);
 
     if(std::isnan(minMax->first))
         minMax->first = y;
@@ -155,12 +424,29 @@ bool ArithmDialog::Prepare()
 {
     // Collect user variables (x, f, g, h, ...)
     m_Parser.dec().collect_variables() = true;
+    m_Parser.dec().collect_assignments() = true;
 
     // Set all variables to not detected
-    m_isLazy = m_isF = m_isG = m_isH = false;
-    bool isX = false;
+    m_isLazy = m_isField = m_isImplicit = m_isParametric = m_isPolar = m_isSweep = m_isXRange = false;
+    m_Active.clear();
+    bool isX = false, isY = false, isT = false, isR = false, isK = false;
+
+    const QString input = ui->input->lineEdit()->text();
+    const exprtk::token_program *program = m_Library.Find(input);
 
-    if(m_Parser.compile(ui->input->lineEdit()->text().toStdString(), m_Expression))
+    // Fall back to the text if the program was built with other settings
+    bool compiled = program && m_Parser.compile(*program, m_Expression);
+    if(compiled)
+        m_Program = *program;
+
+    if(!compiled && (m_Precompiler.Find(input, m_Program) || m_Cache.Load(input, m_Program)))
+        compiled = m_Parser.compile(m_Program, m_Expression);
+
+    // The current program is cached with the history and seeds background sampling
+    if(!compiled)
+        compiled = m_Parser.compile(input.toStdString(), m_Expression, m_Program);
+
+    if(compiled)
     {
         std::deque<arithm_symbol> symbol_list;
         m_Parser.dec().symbols(symbol_list);
@@ -171,14 +457,56 @@ bool ArithmDialog::Prepare()
 
             // Evaluate relevant user variables
             if(found == "x") isX = true;
+            if(found == "y") isY = true;
+            if(found == "t") isT = true;
+            if(found == "r") isR = true;
+            if(found == "k") isK = true;
+
+            // Dependent variables, in the order of m_CurveNames
+            const auto curve = std::find(m_CurveNames.begin(), m_CurveNames.end(), symbol_list[i].first);
+            if(curve != m_CurveNames.end())
+                m_Active.append(int(curve - m_CurveNames.begin()));
 
-            if(found == "f") m_isF = true;
-            if(found == "g") m_isG = true;
-            if(found == "h") m_isH = true;
+            if(found == "z") m_isImplicit = true;
         }
 
-        if(isX && !m_isF && !m_isG && !m_isH)
+        std::sort(m_Active.begin(), m_Active.end());
+
+        // An assigned horizontal range overrides the extent of parametric and polar curves
+        std::deque<arithm_symbol> assignment_list;
+        m_Parser.dec().assignment_symbols(assignment_list);
+
+        for(const arithm_symbol &assignment : assignment_list)
+            m_isXRange = m_isXRange || assignment.first == "x_min" || assignment.first == "x_max";
+
+        const bool isF = m_Active.contains(0), isG = m_Active.contains(1);
+
+        // Implicit, polar and parametric curves take precedence over f, g and h
+        if(m_isImplicit)
+            m_Active.clear();
+        else if(isT && isR)
+        {
+            // One curve, shown in the f slot
+            m_isPolar = true;
+            m_Active = { 0 };
+        }
+        else if(isT && isF && isG)
+        {
+            // One curve through (f, g), shown in the f slot
+            m_isParametric = true;
+            m_Active = { 0 };
+        }
+        // z = f(x, y) fields use the result, like lazy plots
+        else if(isY && m_Active.isEmpty())
+            m_isField = true;
+        else if(isX && m_Active.isEmpty())
+        {
             m_isLazy = true;
+            m_Active = { -1 };
+        }
+
+        // Curves over x using k become a family of curves
+        m_isSweep = isK && isX && !m_Active.isEmpty() && !m_isParametric && !m_isPolar;
 
         return true;
     }
@@ -188,118 +516,126 @@ bool ArithmDialog::Prepare()
 
 void ArithmDialog::Calculate(bool resetZoom)
 {
-    if(Prepare())
-    {
-        // Reset symbols prior to expression evaluation
-        ResetSymbols(resetZoom);
+    // Supersedes any refinement still queued
+    m_GridGeneration++;
+    m_Roots.clear();
+    m_Extrema.clear();
 
-        // Evaluate expression with default symbols
-        arithm_double result = m_Expression.value();
+    // Tiles of the previous plot go on every path, curves over x sample new ones below
+    m_Tiles.Clear();
+    m_PanTileWidth = 0;
+    m_GridCurves.clear();
 
-        if(m_isLazy || m_isF || m_isG || m_isH)
+    if(Prepare())
+    {
+        // Edited input counts as one use, recorded unless superseded while typing
+        if(resetZoom)
         {
-            ui->chart->setUpdatesEnabled(false);
-
-            // Track min/max for plot range settings
-            arithm_pair minMax(std::nanl("1"), std::nanl("1"));
+            m_PendingEntry = ui->input->lineEdit()->text();
+            m_HistoryTimer.start();
+        }
 
-            QLineSeries *Fs = new QLineSeries();
-            QLineSeries *Gs = new QLineSeries();
-            QLineSeries *Hs = new QLineSeries();
+        // Reset symbols prior to expression evaluation
+        ResetSymbols(resetZoom);
 
-            // Fixed horizontal range (we don't want x_min, x_max to be dependent on x)
-            arithm_double a = m_X_Min;
-            arithm_double b = m_X_Max;
+        // Start a new evaluation budget
+        m_Budget.start();
 
-            // Perform calculations
-            for(int i = 0; i < m_Samples; i++)
-            {
-                m_X = a + i * (b - a) / (m_Samples - 1);
+        arithm_double result;
 
-                // re-calculate with new m_X value
-                result = m_Expression.value();
+        try
+        {
+            // Evaluate expression with default symbols
+            result = m_Expression.value();
+        }
+        catch(const std::runtime_error &error)
+        {
+            Abort(error);
+            return;
+        }
 
-                if(m_isF)
-                    AddPair(Fs, m_X, m_F, &minMax);
+        if(m_isImplicit)
+        {
+            ShowImplicit();
 
-                if(m_isG)
-                    AddPair(Gs, m_X, m_G, &minMax);
+            ui->output->setText(QString::fromUtf8("Results for %1 ≤ x ≤ %2").arg(double(m_X_Min)).arg(double(m_X_Max)));
+            ui->output->setStyleSheet(STYLE_HINT);
+            ui->output->setToolTip(ProfileReport());
+        }
+        else if(m_isField)
+        {
+            ShowField();
 
-                if(m_isH)
-                    AddPair(Hs, m_X, m_H, &minMax);
+            ui->output->setText(QString::fromUtf8("Results for %1 ≤ x ≤ %2").arg(double(m_X_Min)).arg(double(m_X_Max)));
+            ui->output->setStyleSheet(STYLE_HINT);
+            ui->output->setToolTip(ProfileReport());
+        }
+        else if(m_isSweep)
+        {
+            // A new expression starts with the whole family
+            if(resetZoom)
+                m_SweepFrame = -1;
 
-                // lazy function plots (e.g. "sin(x)" instead of "f := sin(x)")
-                if(m_isLazy)
-                    AddPair(Fs, m_X, result, &minMax);
-            }
+            ShowSweep();
+        }
+        else if(!m_Active.isEmpty())
+        {
+            const bool isCurve = m_isParametric || m_isPolar;
 
-            // Remove previous plots
-            m_Chart->removeAllSeries();
-            m_Chart->legend()->show();
+            // Track min/max for plot range settings
+            m_GridMinMax = arithm_pair(std::nanl("1"), std::nanl("1"));
 
-            // Add proper or lazy line series
-            if(m_isF || m_isLazy)
-            {
-                if(m_isLazy)
-                {
-                    // hide legend for lazy function plots
-                    m_Chart->legend()->hide();
-                }
-
-                Fs->setName("f(x)");
-                m_Chart->addSeries(Fs);
-            }
+            // Fixed horizontal range (we don't want x_min, x_max to be dependent on x),
+            // parametric and polar curves run over [t_min, t_max] instead
+            if(isCurve)
+                m_GridRange = arithm_pair(std::isnan(m_T_Min) ? PLOT_T_MIN_DEFAULT : m_T_Min,
+                                          std::isnan(m_T_Max) ? PLOT_T_MAX_DEFAULT : m_T_Max);
             else
-                delete Fs;
+                m_GridRange = arithm_pair(m_X_Min, m_X_Max);
 
-            if(m_isG)
-            {
-                Gs->setName("g(x)");
-                m_Chart->addSeries(Gs);
-            }
-            else
-                delete Gs;
+            m_GridX.fill(std::nan("1"), m_Samples);
+            m_GridY.fill(std::nan("1"), m_Samples * m_Active.size());
+
+            // Coarse pass of about PLOT_COARSE_SAMPLES points on every 4^k-th grid index
+            m_GridStride = 1;
+            while((m_Samples - 1) / (m_GridStride * 4) >= PLOT_COARSE_SAMPLES - 1)
+                m_GridStride *= 4;
 
-            if(m_isH)
+            try
             {
-                Hs->setName("h(x)");
-                m_Chart->addSeries(Hs);
+                SamplePass(m_GridStride, 0);
             }
-            else
-                delete Hs;
-
-            // Plot display settings
-            m_Chart->createDefaultAxes();
-
-            if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+            catch(const std::runtime_error &error)
             {
-                m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
-                m_Chart->axes(Qt::Horizontal).first()->setRange(double(m_X_Min), double(m_X_Max));
+                Abort(error);
+                return;
             }
 
-            if(!m_Chart->axes(Qt::Vertical).isEmpty())
-            {
-                m_Chart->axes(Qt::Vertical).first()->setTitleText("function(x)");
+            ShowPass();
 
-                minMax = EvaluateRange(minMax);
-                m_Chart->axes(Qt::Vertical).first()->setRange(
-                            std::isnan(m_Y_Min) ? double(minMax.first) : double(m_Y_Min),
-                            std::isnan(m_Y_Max) ? double(minMax.second): double(m_Y_Max));
-            }
+            // Panning only applies to curves over x
+            if(!isCurve)
+                ResetTiles();
 
-            ui->chart->setUpdatesEnabled(true);
+            // Refine between events, so that new input stops it early
+            const quint64 generation = m_GridGeneration;
+            if(m_GridStride > 1)
+                QTimer::singleShot(0, this, [this, generation]() { Refine(generation); });
 
-            // Display plot boundaries info [x_min, x_max]
-            ui->output->setText(QString::fromUtf8("Results for %1 ≤ x ≤ %2").arg(double(m_X_Min)).arg(double(m_X_Max)));
+            // Display plot boundaries info [x_min, x_max] or [t_min, t_max]
+            if(isCurve)
+                ui->output->setText(QString::fromUtf8("Results for %1 ≤ t ≤ %2").arg(double(m_GridRange.first)).arg(double(m_GridRange.second)));
+            else
+                ui->output->setText(RangeText());
             ui->output->setStyleSheet(STYLE_HINT);
-            ui->output->setToolTip("");
+            ui->output->setToolTip(ProfileReport());
         }
         else
         {
             // Display results only
-            ui->output->setText(QString::number(m_Expression.value(), 'G', 12));
+            ui->output->setText(QString::number(result, 'G', 12));
             ui->output->setStyleSheet(STYLE_ACTIVE);
-            ui->output->setToolTip("");
+            ui->output->setToolTip(ProfileReport());
 
             ResetPlot();
         }
@@ -315,97 +651,1043 @@ void ArithmDialog::Calculate(bool resetZoom)
     }
 }
 
-arithm_pair ArithmDialog::EvaluateRange(arithm_pair minMax)
+void ArithmDialog::SamplePass(int stride, int previous)
 {
-    arithm_pair result = minMax;
-    arithm_double delta = minMax.second - minMax.first;
-    arithm_double factor = 1.0;
-
-    // Restrict plotting of functions to available rounding ranges [1µ, 1M]
-    // Plot smaller ranges as constants and indicate this by vertical scale
-    if(delta < 0.000001)
+    if(m_isParametric || m_isPolar)
     {
-        result.first -= 0.5;
-        result.second += 0.5;
-
-        delta = result.second - result.first;
+        SampleCurve(stride, previous);
+        return;
     }
-    else
+
+    const arithm_double a = m_GridRange.first;
+    const arithm_double b = m_GridRange.second;
+    const int last = m_Samples - 1;
+
+    for(int i = 0; i <= last; i++)
     {
-        // "The manufactured rounding table"
-        if(delta < 0.00005) factor = 0.000001; // 1µ
-        if(delta >= 0.00005 && delta < 0.0005) factor = 0.00001;
-        if(delta >= 0.0005 && delta < 0.005) factor = 0.0001;
-        if(delta >= 0.005 && delta < 0.05) factor = 0.001;
-        if(delta >= 0.05 && delta < 0.5) factor = 0.01;
-        if(delta >= 0.5 && delta < 5.0) factor = 0.1;
-        if(delta >= 5.0 && delta < 50.0) factor = 1.0;
-        if(delta >= 50.0 && delta < 500.0) factor = 10.0;
-        if(delta >= 500.0 && delta < 5000.0) factor = 100.0;
-        if(delta >= 5000.0 && delta < 50000.0) factor = 1000.0;
-        if(delta >= 50000.0 && delta < 500000.0) factor = 10000.0;
-        if(delta >= 500000.0 && delta < 5000000.0) factor = 100000.0;
-        if(delta >= 5000000.0) factor = 1000000.0; // 1M
-    }
+        // Grid indices of this pass, skipping those of the previous one
+        const bool inPass = i % stride == 0 || i == last;
+        const bool inPrevious = previous > 0 && (i % previous == 0 || i == last);
 
-    // Execute rounding (factor = 1.0 for small deltas)
-    result.first = std::floor(result.first / factor) * factor;
-    result.second = std::ceil(result.second / factor) * factor;
+        if(!inPass || inPrevious)
+            continue;
 
-    return result;
-}
+        // Stop sampling once the budget is exhausted
+        m_Budget.checkpoint();
 
-void ArithmDialog::ResetSymbols(bool resetZoom)
-{
-    m_F = std::nanl("1");
-    m_G = std::nanl("1");
-    m_H = std::nanl("1");
-    m_X = std::nanl("1");
+        m_X = a + i * (b - a) / last;
+        m_GridX[i] = double(m_X);
 
-    // Always use default scaling for y_min, x_max unless specified in current expression
-    m_Y_Min = std::nanl("1");
-    m_Y_Max = std::nanl("1");
+        // re-calculate with new m_X value, one evaluation for all curves
+        const arithm_double result = m_Expression.value();
 
-    if(resetZoom)
-    {
-        m_X_Min = m_Settings->value(PLOT_X_MIN_KEY, PLOT_X_MIN_DEFAULT).toFloat();
-        m_X_Max = m_Settings->value(PLOT_X_MAX_KEY, PLOT_X_MAX_DEFAULT).toFloat();
+        // lazy function plots (e.g. "sin(x)" instead of "f := sin(x)") use the result
+        for(int j = 0; j < m_Active.size(); j++)
+        {
+            const int slot = m_Active[j];
+            AddSample(&m_GridY[j * m_Samples + i], slot < 0 ? result : m_CurveValues[slot], &m_GridMinMax);
+        }
     }
 }
 
-void ArithmDialog::ResetPlot()
+void ArithmDialog::SampleCurve(int stride, int previous)
 {
-    ui->chart->setUpdatesEnabled(false);
+    const arithm_double a = m_GridRange.first;
+    const arithm_double b = m_GridRange.second;
+    const int count = (m_Samples - 1) / stride + 1;
 
-    m_Chart->removeAllSeries();
+    QVector<double> ts, xs, ys;
+    QVector<bool> isKept;
 
-    m_Chart->addSeries(new QLineSeries());
-    m_Chart->createDefaultAxes();
+    ts.reserve(count);
+    xs.reserve(count);
+    ys.reserve(count);
+    isKept.reserve(count);
 
-    m_Chart->legend()->hide();
+    if(previous > 0 && m_GridX.size() == m_GridT.size() && m_GridT.size() > 1 && m_GridT.size() < count)
+    {
+        const int size = m_GridT.size();
 
-    if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+        // Lengths relative to the horizontal view, the x extent of the curve unless x_min and x_max are assigned
+        const arithm_pair xRange = m_isXRange || std::isnan(m_GridXRange.first) ? arithm_pair(m_X_Min, m_X_Max) : m_GridXRange;
+
+        const double xScale = std::max(double(xRange.second - xRange.first), 1e-300);
+        const double yScale = std::max(double(m_GridMinMax.second - m_GridMinMax.first), xScale * 1e-6);
+
+        QVector<double> lengths(size - 1);
+        double total = 0;
+
+        for(int i = 1; i < size; i++)
+        {
+            const double length = std::hypot((m_GridX[i] - m_GridX[i - 1]) / xScale,
+                                              (m_GridY[i] - m_GridY[i - 1]) / yScale);
+
+            lengths[i - 1] = std::isfinite(length) ? length : 0.0;
+            total += lengths[i - 1];
+        }
+
+        // Arc length of the previous pass, blended with uniform spacing so that
+        // stationary sections get a few new samples as well
+        const double span = m_GridT.last() - m_GridT.first();
+
+        QVector<double> cumulative(size, 0.0);
+        for(int i = 1; i < size; i++)
+        {
+            const double uniform = span != 0 ? (m_GridT[i] - m_GridT[i - 1]) / span : 1.0 / (size - 1);
+            const double arc = total > 0 ? lengths[i - 1] / total : uniform;
+
+            cumulative[i] = cumulative[i - 1] + (1.0 - PLOT_UNIFORM_SHARE) * arc + PLOT_UNIFORM_SHARE * uniform;
+        }
+
+        // Keep the previous samples and insert the new ones between them,
+        // as many per interval as its share of the length
+        const int extra = count - size;
+        const double scale = cumulative.last() > 0 && std::isfinite(cumulative.last()) ? extra / cumulative.last() : 0.0;
+
+        for(int i = 0; i < size; i++)
+        {
+            ts.append(m_GridT[i]);
+            xs.append(m_GridX[i]);
+            ys.append(m_GridY[i]);
+            isKept.append(true);
+
+            if(i + 1 == size)
+                break;
+
+            const int inserted = int(scale * cumulative[i + 1]) - int(scale * cumulative[i]);
+            for(int j = 1; j <= inserted; j++)
+            {
+                ts.append(m_GridT[i] + j * (m_GridT[i + 1] - m_GridT[i]) / (inserted + 1));
+                xs.append(std::nan("1"));
+                ys.append(std::nan("1"));
+                isKept.append(false);
+            }
+        }
+    }
+    else
     {
-        m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
-        m_Chart->axes(Qt::Horizontal).first()->setRange(double(m_X_Min), double(m_X_Max));
+        for(int i = 0; i < count; i++)
+        {
+            const double u = count > 1 ? double(i) / (count - 1) : 0.0;
+
+            ts.append(double(a + u * (b - a)));
+            xs.append(std::nan("1"));
+            ys.append(std::nan("1"));
+            isKept.append(false);
+        }
     }
 
-    if(!m_Chart->axes(Qt::Vertical).isEmpty())
+    arithm_pair minMax(std::nanl("1"), std::nanl("1"));
+
+    for(int i = 0; i < ts.size(); i++)
     {
-        m_Chart->axes(Qt::Vertical).first()->setTitleText("function(x)");
-        m_Chart->axes(Qt::Vertical).first()->setRange(0.0, 1.0);
-    }
+        if(isKept[i])
+        {
+            AddSample(&ys[i], ys[i], &minMax);
+            continue;
+        }
 
-    m_Chart->setTheme(m_ChartTheme);
-    ui->chart->setFocusPolicy(Qt::NoFocus);
+        // Stop sampling once the budget is exhausted
+        m_Budget.checkpoint();
 
-    ui->chart->setChart(m_Chart);
-    ui->chart->setRenderHint(QPainter::Antialiasing);
+        m_T = ts[i];
+        m_Expression.value();
 
-    ui->chart->setUpdatesEnabled(true);
-}
+        const arithm_double x = m_isPolar ? m_R * std::cos(m_T) : m_CurveValues[0];
+        const arithm_double y = m_isPolar ? m_R * std::sin(m_T) : m_CurveValues[1];
+
+        xs[i] = double(x);
+        AddSample(&ys[i], y, &minMax);
+    }
+
+    // Horizontal extent of the curve, its view unless x_min and x_max are assigned
+    arithm_pair xRange(std::nanl("1"), std::nanl("1"));
+    for(double x : xs)
+    {
+        if(!std::isfinite(x))
+            continue;
+
+        xRange.first = std::isnan(xRange.first) ? x : std::min(xRange.first, arithm_double(x));
+        xRange.second = std::isnan(xRange.second) ? x : std::max(xRange.second, arithm_double(x));
+    }
+
+    m_GridX = xs;
+    m_GridY = ys;
+    m_GridT = ts;
+    m_GridMinMax = minMax;
+    m_GridXRange = xRange;
+}
+
+void ArithmDialog::ShowPass()
+{
+    // Parametric and polar passes replace the whole curve
+    if(m_isParametric || m_isPolar)
+    {
+        QVector<QVector<QPointF>> curves(1);
+        for(int i = 0; i < m_GridX.size(); i++)
+            curves[0].append(QPointF(m_GridX[i], m_GridY[i]));
+
+        ShowCurves(curves, m_GridMinMax);
+        return;
+    }
+
+    QVector<QVector<QPointF>> curves(m_Active.size());
+    const int last = m_Samples - 1;
+
+    for(int j = 0; j < curves.size(); j++)
+    {
+        const double *ys = m_GridY.constData() + j * m_Samples;
+        curves[j].reserve(last / m_GridStride + 2);
+
+        for(int i = 0; i <= last; i++)
+        {
+            if(i % m_GridStride == 0 || i == last)
+                curves[j].append(QPointF(m_GridX[i], ys[i]));
+        }
+    }
+
+    // Split at jumps, poles and gaps, evaluating extra points only around them
+    QVector<double> poles;
+    for(int j = 0; j < curves.size(); j++)
+        curves[j] = SplitCurve(curves[j], m_Active[j], &poles);
+
+    m_GridCurves = curves;
+
+    arithm_pair minMax = CurveRange(curves, poles, double(m_GridRange.second - m_GridRange.first));
+    if(std::isnan(minMax.first))
+        minMax = m_GridMinMax;
+
+    // Roots and extrema only once the grid is complete, candidates come from its samples
+    if(m_GridStride == 1)
+    {
+        FindRoots();
+        FindExtrema();
+    }
+    else
+    {
+        m_Roots.clear();
+        m_Extrema.clear();
+    }
+
+    ShowCurves(curves, minMax);
+}
+
+arithm_pair ArithmDialog::CurveRange(const QVector<QVector<QPointF>> &curves, const QVector<double> &poles, double width) const
+{
+    const std::pair<double, double> range = ArithmSplit::Range(curves, poles, width);
+
+    return arithm_pair(range.first, range.second);
+}
+
+arithm_double ArithmDialog::EvaluateAt(arithm_double x, int slot)
+{
+    m_X = x;
+
+    const arithm_double result = m_Expression.value();
+
+    return slot < 0 ? result : m_CurveValues[slot];
+}
+
+QVector<QPointF> ArithmDialog::SplitCurve(const QVector<QPointF> &samples, int slot, QVector<double> *poles)
+{
+    QVector<QPointF> result;
+    ArithmSplit::Curve(samples, [this, slot](double x) { return double(EvaluateAt(x, slot)); }, result, poles);
+
+    return result;
+}
+
+bool ArithmDialog::Refine(quint64 generation)
+{
+    // Input changed, zoomed or panned in the meantime
+    if(generation != m_GridGeneration || m_isPanning || m_isSweep || m_GridStride <= 1)
+        return false;
+
+    const int previous = m_GridStride;
+    m_GridStride /= 4;
+
+    m_Budget.start();
+
+    try
+    {
+        SamplePass(m_GridStride, previous);
+    }
+    catch(const std::runtime_error &)
+    {
+        // Keep the coarser plot
+        m_GridStride = previous;
+        return false;
+    }
+
+    ShowPass();
+
+    if(m_GridStride > 1)
+        QTimer::singleShot(0, this, [this, generation]() { Refine(generation); });
+    else if(!m_isParametric && !m_isPolar)
+        ui->output->setText(RangeText());
+
+    return true;
+}
+
+QString ArithmDialog::CurveName(int curve) const
+{
+    // Parametric and polar curves use the f slot only
+    if(m_isPolar)
+        return "r(t)";
+    if(m_isParametric)
+        return "(f(t), g(t))";
+
+    const int count = qMax(1, m_Active.size());
+    const int slot = m_Active.value(curve % count, -1);
+    const QString name = QString::fromStdString(slot < 0 ? "f" : m_CurveNames[slot]) + "(x)";
+
+    // Members of a family, one after another
+    if(m_isSweep)
+    {
+        const int member = m_SweepFrame >= 0 ? m_SweepFrame : curve / count;
+        return name + QString(", k = %1").arg(m_SweepValues.value(member));
+    }
+
+    return name;
+}
+
+void ArithmDialog::ShowCurves(const QVector<QVector<QPointF>> &curves, arithm_pair minMax)
+{
+    minMax = EvaluateRange(minMax);
+
+    const double yMin = std::isnan(m_Y_Min) ? double(minMax.first) : double(m_Y_Min);
+    const double yMax = std::isnan(m_Y_Max) ? double(minMax.second): double(m_Y_Max);
+
+    const bool isCurve = m_isParametric || m_isPolar;
+
+    // Parametric and polar curves span their own x extent, unless x_min and x_max are assigned
+    arithm_pair xRange(m_X_Min, m_X_Max);
+    if(isCurve && !m_isXRange && !std::isnan(m_GridXRange.first))
+        xRange = EvaluateRange(m_GridXRange);
+
+    const double xMin = double(xRange.first);
+    const double xMax = double(xRange.second);
+
+    m_Curves = curves;
+    m_YRange = arithm_pair(yMin, yMax);
+    m_isPlotted = true;
+
+    if(m_Plot)
+    {
+        m_Plot->SetView(xMin, xMax, yMin, yMax);
+        m_Plot->SetField(QImage(), QRectF(), QVector<QLineF>());
+        m_Plot->SetLegendVisible(!m_isLazy && !isCurve && !(m_isSweep && m_SweepFrame < 0));
+
+        m_Plot->SetCurveCount(curves.size());
+        for(int i = 0; i < curves.size(); i++)
+            m_Plot->SetCurve(i, CurveName(i), curves[i]);
+
+        m_Plot->SetMarkers(Markers());
+        return;
+    }
+
+    ui->chart->setUpdatesEnabled(false);
+
+    // Remove previous plots
+    m_Chart->removeAllSeries();
+    m_Chart->setPlotAreaBackgroundVisible(false);
+    m_Chart->legend()->show();
+
+    // hide legend for lazy function plots and whole families
+    if(m_isLazy || isCurve || (m_isSweep && m_SweepFrame < 0))
+        m_Chart->legend()->hide();
+
+    // Add proper or lazy line series
+    for(int i = 0; i < curves.size(); i++)
+        AddSeries(CurveName(i), curves[i]);
+
+    const QVector<QPointF> markers = Markers();
+    if(!markers.isEmpty())
+    {
+        QScatterSeries *series = new QScatterSeries();
+        series->setMarkerSize(8);
+        series->replace(markers);
+        m_Chart->addSeries(series);
+
+        for(QLegendMarker *marker : m_Chart->legend()->markers(series))
+            marker->setVisible(false);
+    }
+
+    // Plot display settings
+    m_Chart->createDefaultAxes();
+
+    if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+    {
+        m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
+        m_Chart->axes(Qt::Horizontal).first()->setRange(xMin, xMax);
+    }
+
+    if(!m_Chart->axes(Qt::Vertical).isEmpty())
+    {
+        m_Chart->axes(Qt::Vertical).first()->setTitleText(isCurve ? "y" : "function(x)");
+        m_Chart->axes(Qt::Vertical).first()->setRange(yMin, yMax);
+    }
+
+    ui->chart->setUpdatesEnabled(true);
+}
+
+void ArithmDialog::FindRoots()
+{
+    m_Roots.clear();
+
+    const int count = m_Active.size();
+    const int last = m_Samples - 1;
+
+    // Sign changes of every curve, and of the differences of a few curves
+    QVector<ArithmRootBracket> brackets;
+    for(int j = 0; j < count; j++)
+    {
+        for(int l = j; l < count; l++)
+        {
+            if(l != j && count > PLOT_ROOT_PAIRS)
+                break;
+
+            const double *a = m_GridY.constData() + j * m_Samples;
+            const double *b = m_GridY.constData() + l * m_Samples;
+
+            for(int i = 0; i < last && brackets.size() < PLOT_MAX_ROOTS; i++)
+            {
+                const double d0 = l == j ? a[i] : a[i] - b[i];
+                const double d1 = l == j ? a[i + 1] : a[i + 1] - b[i + 1];
+
+                if(std::isfinite(d0) && std::isfinite(d1) && (d0 < 0) != (d1 < 0))
+                    brackets.append(ArithmRootBracket{ m_GridX[i], m_GridX[i + 1], j, l == j ? -1 : l });
+            }
+        }
+    }
+
+    if(brackets.isEmpty())
+        return;
+
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+
+    std::vector<std::string> curves;
+    for(int slot : m_Active)
+        curves.push_back(slot < 0 ? "" : m_CurveNames[slot]);
+
+    ArithmRoots roots(m_Program, variables, curves);
+    roots.SetBudget(&m_Budget);
+
+    m_Roots = roots.Find(brackets);
+}
+
+void ArithmDialog::FindExtrema()
+{
+    m_Extrema.clear();
+
+    if(m_ExtremaExpression != m_Program.expression())
+    {
+        m_ExtremaCache.clear();
+        m_ExtremaExpression = m_Program.expression();
+    }
+
+    const int last = m_Samples - 1;
+    QVector<ArithmExtremumBracket> candidates;
+
+    for(int j = 0; j < m_Active.size(); j++)
+    {
+        const double *y = m_GridY.constData() + j * m_Samples;
+
+        // Curvature below this is rounding noise of straight sections
+        double scale = 0;
+        for(int i = 0; i <= last; i++)
+        {
+            if(std::isfinite(y[i]))
+                scale = std::max(scale, std::abs(y[i]));
+        }
+
+        const double noise = PLOT_CURVATURE_NOISE * scale;
+
+        for(int i = 1; i < last; i++)
+        {
+            if(!std::isfinite(y[i - 1]) || !std::isfinite(y[i]) || !std::isfinite(y[i + 1]))
+                continue;
+
+            // Slope changes sign around sample i
+            const double d0 = y[i] - y[i - 1], d1 = y[i + 1] - y[i];
+            if((d0 > 0 && d1 < 0) || (d0 < 0 && d1 > 0))
+                candidates.append(ArithmExtremumBracket{ m_GridX[i - 1], m_GridX[i + 1], j,
+                                                         d0 > 0 ? ArithmExtremum::Maximum : ArithmExtremum::Minimum });
+
+            // Second difference changes sign between samples i and i + 1
+            if(i + 2 <= last && std::isfinite(y[i + 2]))
+            {
+                const double c0 = d1 - d0, c1 = y[i + 2] - 2.0 * y[i + 1] + y[i];
+                if(std::abs(c0) > noise && std::abs(c1) > noise && (c0 > 0) != (c1 > 0))
+                    candidates.append(ArithmExtremumBracket{ m_GridX[i], m_GridX[i + 1], j, ArithmExtremum::Inflection });
+            }
+        }
+    }
+
+    // Points refined for an earlier grid of this expression need no evaluation
+    QVector<ArithmExtremumBracket> brackets;
+    for(const ArithmExtremumBracket &candidate : candidates)
+    {
+        bool isCached = false;
+        for(const ArithmExtremum &point : m_ExtremaCache)
+        {
+            if(point.curve == candidate.curve && point.kind == candidate.kind &&
+                    point.x >= candidate.a && point.x <= candidate.b)
+            {
+                m_Extrema.append(point);
+                isCached = true;
+                break;
+            }
+        }
+
+        if(!isCached && brackets.size() < PLOT_MAX_EXTREMA)
+            brackets.append(candidate);
+    }
+
+    if(!brackets.isEmpty())
+    {
+        std::vector<std::string> variables;
+        m_Symbols.get_variable_list(variables);
+
+        std::vector<std::string> curves;
+        for(int slot : m_Active)
+            curves.push_back(slot < 0 ? "" : m_CurveNames[slot]);
+
+        ArithmExtrema extrema(m_Program, variables, curves);
+        extrema.SetBudget(&m_Budget);
+
+        // Second differences on a step well below the grid spacing
+        const QVector<ArithmExtremum> found = extrema.Find(brackets, double(m_X_Max - m_X_Min) / last / 64);
+
+        m_Extrema += found;
+        m_ExtremaCache += found;
+
+        if(m_ExtremaCache.size() > PLOT_EXTREMA_CACHE)
+            m_ExtremaCache.remove(0, m_ExtremaCache.size() - PLOT_EXTREMA_CACHE);
+    }
+
+    // Grouped by curve and kind for the result line
+    std::sort(m_Extrema.begin(), m_Extrema.end(), [](const ArithmExtremum &a, const ArithmExtremum &b)
+    {
+        if(a.curve != b.curve)
+            return a.curve < b.curve;
+        if(a.kind != b.kind)
+            return a.kind < b.kind;
+        return a.x < b.x;
+    });
+}
+
+QString ArithmDialog::RangeText() const
+{
+    QString text = QString::fromUtf8("Results for %1 ≤ x ≤ %2").arg(double(m_X_Min)).arg(double(m_X_Max));
+
+    // Roots grouped by curve, e.g. "f(x) = 0 at x ≈ 1.5708, 4.71239"
+    QStringList groups;
+    QString label;
+    int listed = 0;
+
+    for(const ArithmRoot &root : m_Roots)
+    {
+        const QString current = CurveName(root.first) + " = " + (root.second < 0 ? QString("0") : CurveName(root.second));
+
+        if(listed++ == PLOT_POINTS_LISTED)
+        {
+            groups.last() += QString::fromUtf8(", …");
+            break;
+        }
+
+        if(current != label)
+        {
+            label = current;
+            groups << label + QString::fromUtf8(" at x ≈ ") + QString::number(root.x, 'G', 6);
+        }
+        else
+            groups.last() += ", " + QString::number(root.x, 'G', 6);
+    }
+
+    // Extrema and inflection points, e.g. "f(x) max at x ≈ 1.5708"
+    static const char *kinds[] = { " min", " max", " inflection" };
+
+    for(int i = 0; i < m_Extrema.size() && listed <= PLOT_POINTS_LISTED; i++)
+    {
+        const ArithmExtremum &point = m_Extrema[i];
+        const QString current = CurveName(point.curve) + kinds[point.kind];
+
+        if(listed++ == PLOT_POINTS_LISTED)
+        {
+            groups.last() += QString::fromUtf8(", …");
+            break;
+        }
+
+        if(current != label)
+        {
+            label = current;
+            groups << label + QString::fromUtf8(" at x ≈ ") + QString::number(point.x, 'G', 6);
+        }
+        else
+            groups.last() += ", " + QString::number(point.x, 'G', 6);
+    }
+
+    if(!groups.isEmpty())
+        text += "; " + groups.join("; ");
+
+    return text;
+}
+
+QVector<QPointF> ArithmDialog::Markers() const
+{
+    QVector<QPointF> markers;
+
+    for(const ArithmRoot &root : m_Roots)
+        markers.append(QPointF(root.x, root.y));
+
+    for(const ArithmExtremum &point : m_Extrema)
+        markers.append(QPointF(point.x, point.y));
+
+    return markers;
+}
+
+void ArithmDialog::AddSeries(const QString &name, const QVector<QPointF> &points)
+{
+    // One QLineSeries per segment, sharing colour and legend entry
+    QLineSeries *first = nullptr;
+    QVector<QPointF> segment;
+
+    for(int i = 0; i <= points.size(); i++)
+    {
+        if(i < points.size() && std::isfinite(points[i].y()))
+        {
+            segment.append(points[i]);
+            continue;
+        }
+
+        if(segment.isEmpty())
+            continue;
+
+        QLineSeries *series = new QLineSeries();
+        series->setName(name);
+        series->replace(segment);
+        m_Chart->addSeries(series);
+
+        if(first)
+        {
+            series->setColor(first->color());
+            for(QLegendMarker *marker : m_Chart->legend()->markers(series))
+                marker->setVisible(false);
+        }
+        else
+            first = series;
+
+        segment.clear();
+    }
+}
+
+void ArithmDialog::ShowField()
+{
+    // Square domain unless y_min and y_max are given
+    const double xMin = double(m_X_Min), xMax = double(m_X_Max);
+    const double yMin = std::isnan(m_Y_Min) ? xMin : double(m_Y_Min);
+    const double yMax = std::isnan(m_Y_Max) ? xMax : double(m_Y_Max);
+
+    if(m_FieldExpression != m_Program.expression())
+    {
+        std::vector<std::string> variables;
+        m_Symbols.get_variable_list(variables);
+
+        m_Field.Reset(m_Program, variables);
+        m_FieldExpression = m_Program.expression();
+    }
+
+    const QSize viewport = m_Plot ? m_Plot->PlotArea().size() : m_Chart->plotArea().size().toSize();
+
+    // Grid memory is bounded by the viewport, not by the zoom level
+    QVector<float> z;
+    QSize size;
+    QRectF extent;
+    m_Field.Sample(QRectF(xMin, yMin, xMax - xMin, yMax - yMin), viewport, m_FieldResolution, z, size, extent);
+
+    const QImage image = ArithmField::Colorize(z, size);
+    const QVector<QLineF> contours = ArithmField::Contours(z, size, extent, m_FieldContours);
+
+    m_isPlotted = false;
+
+    if(m_Plot)
+    {
+        m_Plot->SetView(xMin, xMax, yMin, yMax);
+        m_Plot->SetCurveCount(0);
+        m_Plot->SetField(image, extent, contours);
+        m_Plot->SetMarkers(QVector<QPointF>());
+        return;
+    }
+
+    // QtCharts shows the image as plot area background, without contours
+    ui->chart->setUpdatesEnabled(false);
+
+    m_Chart->removeAllSeries();
+    m_Chart->legend()->hide();
+    m_Chart->addSeries(new QLineSeries());
+    m_Chart->createDefaultAxes();
+
+    if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+    {
+        m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
+        m_Chart->axes(Qt::Horizontal).first()->setRange(xMin, xMax);
+    }
+
+    if(!m_Chart->axes(Qt::Vertical).isEmpty())
+    {
+        m_Chart->axes(Qt::Vertical).first()->setTitleText("y");
+        m_Chart->axes(Qt::Vertical).first()->setRange(yMin, yMax);
+    }
+
+    const QRectF visible(xMin, yMin, xMax - xMin, yMax - yMin);
+    const QRect crop(int((visible.left() - extent.left()) / extent.width() * size.width()),
+                     int((extent.bottom() - visible.bottom()) / extent.height() * size.height()),
+                     int(visible.width() / extent.width() * size.width()),
+                     int(visible.height() / extent.height() * size.height()));
+
+    if(!crop.isEmpty())
+    {
+        QBrush background(image.copy(crop).scaled(m_Chart->plotArea().size().toSize()));
+        background.setTransform(QTransform::fromTranslate(m_Chart->plotArea().left(), m_Chart->plotArea().top()));
+
+        m_Chart->setPlotAreaBackgroundBrush(background);
+        m_Chart->setPlotAreaBackgroundVisible(true);
+    }
+
+    ui->chart->setUpdatesEnabled(true);
+}
+
+void ArithmDialog::ShowImplicit()
+{
+    // Same domain as fields
+    const double xMin = double(m_X_Min), xMax = double(m_X_Max);
+    const double yMin = std::isnan(m_Y_Min) ? xMin : double(m_Y_Min);
+    const double yMax = std::isnan(m_Y_Max) ? xMax : double(m_Y_Max);
+
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+
+    ArithmImplicit implicit(m_Program, variables, "z");
+    implicit.SetBudget(&m_Budget);
+
+    // Refine down to cells of about one pixel
+    const QSize viewport = m_Plot ? m_Plot->PlotArea().size() : m_Chart->plotArea().size().toSize();
+    const int maxDepth = qMax(PLOT_IMPLICIT_DEPTH, int(std::ceil(std::log2(qMax(1, qMax(viewport.width(), viewport.height()))))));
+
+    const QVector<QPointF> points = implicit.Trace(QRectF(xMin, yMin, xMax - xMin, yMax - yMin), PLOT_IMPLICIT_DEPTH, maxDepth);
+
+    m_isPlotted = false;
+
+    if(m_Plot)
+    {
+        m_Plot->SetField(QImage(), QRectF(), QVector<QLineF>());
+        m_Plot->SetMarkers(QVector<QPointF>());
+        m_Plot->SetView(xMin, xMax, yMin, yMax);
+        m_Plot->SetLegendVisible(false);
+        m_Plot->SetCurveCount(1);
+        m_Plot->SetCurve(0, "z", points);
+        return;
+    }
+
+    ui->chart->setUpdatesEnabled(false);
+
+    m_Chart->removeAllSeries();
+    m_Chart->legend()->hide();
+    m_Chart->setPlotAreaBackgroundVisible(false);
+
+    AddSeries("z", points);
+    if(m_Chart->series().isEmpty())
+        m_Chart->addSeries(new QLineSeries());
+
+    m_Chart->createDefaultAxes();
+
+    if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+    {
+        m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
+        m_Chart->axes(Qt::Horizontal).first()->setRange(xMin, xMax);
+    }
+
+    if(!m_Chart->axes(Qt::Vertical).isEmpty())
+    {
+        m_Chart->axes(Qt::Vertical).first()->setTitleText("y");
+        m_Chart->axes(Qt::Vertical).first()->setRange(yMin, yMax);
+    }
+
+    ui->chart->setUpdatesEnabled(true);
+}
+
+void ArithmDialog::ShowSweep()
+{
+    // k_min, k_max and k_step as assigned by the expression
+    const double kMin = std::isnan(m_K_Min) ? PLOT_SWEEP_MIN_DEFAULT : double(m_K_Min);
+    const double kMax = std::isnan(m_K_Max) ? PLOT_SWEEP_MAX_DEFAULT : double(m_K_Max);
+    const double kStep = std::isnan(m_K_Step) || m_K_Step <= 0 ? PLOT_SWEEP_STEP_DEFAULT : double(m_K_Step);
+
+    m_SweepValues.clear();
+    for(int i = 0; i < PLOT_SWEEP_MEMBERS && kMin + i * kStep <= kMax + 1e-9 * kStep; i++)
+        m_SweepValues.append(kMin + i * kStep);
+
+    if(m_SweepFrame >= m_SweepValues.size())
+        m_SweepFrame = -1;
+
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+
+    std::vector<std::string> curves;
+    for(int slot : m_Active)
+        curves.push_back(slot < 0 ? "" : m_CurveNames[slot]);
+
+    // Compiled once per worker thread, members are sampled and split in parallel and kept for scrubbing
+    m_Sweep.Reset(m_Program, variables, curves, "k");
+    const QVector<ArithmSweepFrame> frames = m_Sweep.Frames(double(m_X_Min), double(m_X_Max), m_Samples, m_SweepValues);
+
+    // Members come split at jumps and poles with their range, so scrubbing only picks among them
+    arithm_pair minMax(std::nanl("1"), std::nanl("1"));
+    QVector<QVector<QPointF>> shown;
+
+    for(int i = 0; i < frames.size(); i++)
+    {
+        if(!std::isnan(frames[i].yMin))
+        {
+            minMax.first = std::isnan(minMax.first) ? frames[i].yMin : std::min(minMax.first, arithm_double(frames[i].yMin));
+            minMax.second = std::isnan(minMax.second) ? frames[i].yMax : std::max(minMax.second, arithm_double(frames[i].yMax));
+        }
+
+        if(m_SweepFrame < 0 || m_SweepFrame == i)
+            shown += frames[i].curves;
+    }
+
+    // The vertical range covers the whole family, so that it stays put while scrubbing
+    ShowCurves(shown, minMax);
+
+    if(m_SweepFrame >= 0)
+        ui->output->setText(QString::fromUtf8("Results for k = %1").arg(m_SweepValues[m_SweepFrame]));
+    else
+        ui->output->setText(QString::fromUtf8("Results for %1 ≤ k ≤ %2").arg(m_SweepValues.value(0)).arg(m_SweepValues.isEmpty() ? 0.0 : m_SweepValues.last()));
+
+    ui->output->setStyleSheet(STYLE_HINT);
+    ui->output->setToolTip(ProfileReport());
+}
+
+void ArithmDialog::Abort(const std::runtime_error &error)
+{
+    // Evaluation budget exhausted (e.g. "while(true){}")
+    ui->output->setText(tr("Evaluation aborted"));
+    ui->output->setStyleSheet(STYLE_HINT);
+    ui->output->setToolTip(QString::fromStdString(error.what()));
+
+    ResetPlot();
+}
+
+QString ArithmDialog::Profile(const QString &expression)
+{
+    m_Parser.settings().enable_profiling();
+
+    ui->input->blockSignals(true);
+    ui->input->lineEdit()->setText(expression);
+    ui->input->blockSignals(false);
+
+    Calculate(true);
+
+    // Profile the fully refined plot
+    while(m_isPlotted && Refine(m_GridGeneration))
+        ;
+
+    QString report = QString::fromStdString(m_Expression.profile().to_json());
+
+    // Keep profiled expressions out of the history
+    ui->input->blockSignals(true);
+    ui->input->lineEdit()->clear();
+    ui->input->blockSignals(false);
+
+    m_HistoryTimer.stop();
+    m_PendingEntry.clear();
+
+    return report;
+}
+
+int ArithmDialog::BuildLibrary(const QString &formulas)
+{
+    QFile file(formulas);
+
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return -1;
+
+    m_Library.Clear();
+
+    // One formula per line, formulas that do not compile are skipped
+    QTextStream stream(&file);
+    while(!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+
+        exprtk::token_program program;
+        if(!line.isEmpty() && m_Parser.compile(line.toStdString(), m_Expression, program))
+            m_Library.Add(program);
+    }
+
+    if(!m_Library.Save(m_Settings->value(RUNTIME_LIBRARY_KEY, RUNTIME_LIBRARY_DEFAULT).toString()))
+        return -1;
+
+    return m_Library.Count();
+}
+
+qint64 ArithmDialog::EvaluateData(const QString &expression, const QString &input, const QString &output, QString &error)
+{
+    ArithmDataset dataset;
+    dataset.SetBudget(&m_Budget);
+
+    const qint64 rows = dataset.Evaluate(expression, input, output);
+    error = dataset.Error();
+
+    return rows;
+}
+
+QString ArithmDialog::ProfileReport() const
+{
+    const exprtk::expression_profile &profile = m_Expression.profile();
+
+    if(profile.empty())
+        return "";
+
+    // Hottest statements and bracketed sub-expressions first
+    std::vector<const exprtk::expression_profile::entry*> hottest = profile.hottest();
+
+    QStringList lines;
+    for(std::size_t i = 0; i < hottest.size() && i < RUNTIME_PROFILE_ENTRIES; i++)
+    {
+        lines << QString("%1 ticks  %2 calls  %3")
+                 .arg(hottest[i]->ticks)
+                 .arg(hottest[i]->calls)
+                 .arg(QString::fromStdString(hottest[i]->text));
+    }
+
+    return lines.join("\n");
+}
+
+arithm_pair ArithmDialog::EvaluateRange(arithm_pair minMax)
+{
+    arithm_pair result = minMax;
+    arithm_double delta = minMax.second - minMax.first;
+    arithm_double factor = 1.0;
+
+    // Restrict plotting of functions to available rounding ranges [1µ, 1M]
+    // Plot smaller ranges as constants and indicate this by vertical scale
+    if(delta < 0.000001)
+    {
+        result.first -= 0.5;
+        result.second += 0.5;
+
+        delta = result.second - result.first;
+    }
+    else
+    {
+        factor = PlotRoundingFactor(double(delta));
+    }
+
+    // Execute rounding (factor = 1.0 for small deltas)
+    result.first = std::floor(result.first / factor) * factor;
+    result.second = std::ceil(result.second / factor) * factor;
+
+    return result;
+}
+
+void ArithmDialog::ResetSymbols(bool resetZoom)
+{
+    std::fill(m_CurveValues.begin(), m_CurveValues.end(), std::nanl("1"));
+    m_X = std::nanl("1");
+    m_Y = std::nanl("1");
+    m_Z = std::nanl("1");
+    m_T = std::nanl("1");
+    m_R = std::nanl("1");
+
+    // Always use default scaling for y_min, x_max unless specified in current expression
+    m_Y_Min = std::nanl("1");
+    m_Y_Max = std::nanl("1");
+
+    m_T_Min = std::nanl("1");
+    m_T_Max = std::nanl("1");
+
+    m_K = std::nanl("1");
+    m_K_Min = std::nanl("1");
+    m_K_Max = std::nanl("1");
+    m_K_Step = std::nanl("1");
+
+    if(resetZoom)
+    {
+        m_X_Min = m_Settings->value(PLOT_X_MIN_KEY, PLOT_X_MIN_DEFAULT).toFloat();
+        m_X_Max = m_Settings->value(PLOT_X_MAX_KEY, PLOT_X_MAX_DEFAULT).toFloat();
+    }
+}
+
+void ArithmDialog::ResetCache()
+{
+    if(m_Settings->value(RUNTIME_CACHE_KEY, RUNTIME_CACHE_DEFAULT).toInt() == 0)
+        return;
+
+    // Programs depend on the registered symbols and parser settings
+    std::vector<std::string> variables;
+    m_Symbols.get_variable_list(variables);
+    std::sort(variables.begin(), variables.end());
+
+    QStringList signature;
+    signature << APP_VERSION << QString::number(m_Parser.settings().profiling_enabled());
+    for(const std::string &variable : variables)
+        signature << QString::fromStdString(variable);
+
+    m_Cache.SetSignature(signature.join(","));
+    m_Cache.SetDirectory(QFileInfo(m_Settings->fileName()).absolutePath() + "/" + RUNTIME_CACHE_DIRECTORY, m_HistoryCount);
+}
+
+void ArithmDialog::ResetPlot()
+{
+    m_isPlotted = false;
+
+    if(m_Plot)
+    {
+        m_Plot->SetField(QImage(), QRectF(), QVector<QLineF>());
+        m_Plot->SetMarkers(QVector<QPointF>());
+        m_Plot->SetView(double(m_X_Min), double(m_X_Max), 0.0, 1.0);
+        m_Plot->SetCurveCount(0);
+        return;
+    }
+
+    ui->chart->setUpdatesEnabled(false);
+
+    m_Chart->removeAllSeries();
+    m_Chart->setPlotAreaBackgroundVisible(false);
+
+    m_Chart->addSeries(new QLineSeries());
+    m_Chart->createDefaultAxes();
+
+    m_Chart->legend()->hide();
+
+    if(!m_Chart->axes(Qt::Horizontal).isEmpty())
+    {
+        m_Chart->axes(Qt::Horizontal).first()->setTitleText("x");
+        m_Chart->axes(Qt::Horizontal).first()->setRange(double(m_X_Min), double(m_X_Max));
+    }
+
+    if(!m_Chart->axes(Qt::Vertical).isEmpty())
+    {
+        m_Chart->axes(Qt::Vertical).first()->setTitleText("function(x)");
+        m_Chart->axes(Qt::Vertical).first()->setRange(0.0, 1.0);
+    }
+
+    m_Chart->setTheme(m_ChartTheme);
+    ui->chart->setFocusPolicy(Qt::NoFocus);
+
+    ui->chart->setChart(m_Chart);
+    ui->chart->setRenderHint(QPainter::Antialiasing);
+
+    ui->chart->setUpdatesEnabled(true);
+}
+
+void ArithmDialog::on_input_editTextChanged(const QString& /* arg1 */)
+{
+    // Newer input supersedes any evaluation still in progress
+    m_Budget.cancel();
 
-void ArithmDialog::on_input_editTextChanged(const QString& /* arg1 */)
-{
     Calculate(true);
 }
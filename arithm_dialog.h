@@ -3,9 +3,27 @@
 #include <QDialog>
 #include <QChart>
 #include <QtCharts/QLineSeries>
+#include <QtCharts/QScatterSeries>
 #include <QSettings>
+#include <QTimer>
 
 #include "exprtk.hpp"
+#include "arithm_budget.h"
+#include "arithm_cache.h"
+#include "arithm_dataset.h"
+#include "arithm_evaluator.h"
+#include "arithm_extrema.h"
+#include "arithm_field.h"
+#include "arithm_history.h"
+#include "arithm_history_index.h"
+#include "arithm_implicit.h"
+#include "arithm_library.h"
+#include "arithm_optimizer.h"
+#include "arithm_plot.h"
+#include "arithm_precompiler.h"
+#include "arithm_roots.h"
+#include "arithm_sweep.h"
+#include "arithm_tiles.h"
 #include "settings.h"
 
 QT_BEGIN_NAMESPACE
@@ -13,8 +31,6 @@ namespace Ui { class Dialog; }
 QT_END_NAMESPACE
 
 // Exprtk
-typedef long double arithm_double;
-typedef std::pair<arithm_double, arithm_double> arithm_pair;
 typedef exprtk::parser<arithm_double>::dependent_entity_collector::symbol_t arithm_symbol;
 
 class ArithmDialog : public QDialog
@@ -25,6 +41,10 @@ public:
     ArithmDialog(QWidget *parent = nullptr);
     ~ArithmDialog();
 
+    QString Profile(const QString &expression);
+    int BuildLibrary(const QString &formulas);
+    qint64 EvaluateData(const QString &expression, const QString &input, const QString &output, QString &error);
+
 private slots:
     void on_input_editTextChanged(const QString &arg1);
 
@@ -34,30 +54,78 @@ private:
 
     void ResetSymbols(bool resetZoom = false);
     void ResetPlot();
+    void ResetCache();
 
     void LoadHistory();
     void SaveHistory();
-
-    void AddPair(QLineSeries *series, const arithm_double x, const arithm_double y, arithm_pair *minMax);
+    void PrecompileHistory();
+    void CompleteHistory(const QString &text);
+
+    void Abort(const std::runtime_error &error);
+    QString ProfileReport() const;
+
+    void AddSample(double *sample, const arithm_double y, arithm_pair *minMax);
+    QString CurveName(int curve) const;
+    void SamplePass(int stride, int previous);
+    void SampleCurve(int stride, int previous);
+    void ShowPass();
+    arithm_pair CurveRange(const QVector<QVector<QPointF>> &curves, const QVector<double> &poles, double width) const;
+    arithm_double EvaluateAt(arithm_double x, int slot);
+    QVector<QPointF> SplitCurve(const QVector<QPointF> &samples, int slot, QVector<double> *poles);
+    bool Refine(quint64 generation);
+    void Pan();
+    ArithmTile GridTile(double a, double b) const;
+    void ResetTiles();
+    void ShowField();
+    void ShowImplicit();
+    void ShowSweep();
+    void FindRoots();
+    void FindExtrema();
+    QString RangeText() const;
+    QVector<QPointF> Markers() const;
+    void AddSeries(const QString &name, const QVector<QPointF> &points);
+    void ShowCurves(const QVector<QVector<QPointF>> &curves, arithm_pair minMax);
     arithm_pair EvaluateRange(arithm_pair minMax);
 
 protected:
     void wheelEvent( QWheelEvent * event );
+    bool eventFilter( QObject * object, QEvent * event );
+    void showEvent( QShowEvent * event );
 
 private:
     Ui::Dialog *ui;
 
 private:
+    ArithmBudget m_Budget;
+
     exprtk::symbol_table<arithm_double> m_Symbols;
+    ArithmOptimizer m_Optimizer;
     exprtk::expression<arithm_double> m_Expression;
     exprtk::parser<arithm_double> m_Parser;
 
+    ArithmLibrary m_Library;
+    ArithmCache m_Cache;
+    exprtk::token_program m_Program;
+
+    ArithmHistory m_History;
+    ArithmHistoryIndex m_HistoryIndex;
+    ArithmHistoryModel *m_HistoryModel;
+    ArithmHistoryModel *m_CompletionModel;
+    QTimer m_HistoryTimer;
+    QString m_PendingEntry;
+    ArithmPrecompiler m_Precompiler;
+    bool m_isPrecompiled = false;
+
     QChart::ChartTheme m_ChartTheme = PLOT_THEME_DEFAULT;
 
     int m_Samples = PLOT_SAMPLES_DEFAULT;
     int m_HistoryCount = HISTORY_COUNT_DEFAULT;
 
     arithm_double m_X;
+    arithm_double m_Y = std::nanl("1");
+    arithm_double m_Z = std::nanl("1");
+    arithm_double m_T = std::nanl("1"), m_R = std::nanl("1");
+    arithm_double m_K = std::nanl("1");
 
     arithm_double m_X_Min = PLOT_X_MIN_DEFAULT;
     arithm_double m_X_Max = PLOT_X_MAX_DEFAULT;
@@ -65,11 +133,74 @@ private:
     arithm_double m_Y_Min = std::nanl("1");
     arithm_double m_Y_Max = std::nanl("1");
 
-    arithm_double m_F = std::nanl("1"), m_G = std::nanl("1"), m_H = std::nanl("1");
+    arithm_double m_T_Min = std::nanl("1");
+    arithm_double m_T_Max = std::nanl("1");
+
+    arithm_double m_K_Min = std::nanl("1");
+    arithm_double m_K_Max = std::nanl("1");
+    arithm_double m_K_Step = std::nanl("1");
+
+    // Dependent variables f, g, h and f1..fN, fixed storage bound to the symbol table
+    std::vector<std::string> m_CurveNames;
+    std::vector<arithm_double> m_CurveValues;
+
+    // Curves of the current expression as indices into m_CurveValues, -1 for the result
+    QVector<int> m_Active;
+
+    bool m_isLazy = false, m_isField = false, m_isImplicit = false;
+    bool m_isParametric = false, m_isPolar = false, m_isSweep = false;
 
-    bool m_isLazy, m_isF, m_isG, m_isH = false;
+    // x_min or x_max assigned by the expression
+    bool m_isXRange = false;
 
 private:
     QChart *m_Chart;
+    ArithmPlot *m_Plot = nullptr;
+
+    // Sample grid, filled in passes of increasing density, with one x
+    // array and the values of all active curves one after another
+    QVector<double> m_GridX;
+    QVector<double> m_GridY;
+    arithm_pair m_GridRange;
+    QVector<double> m_GridT;
+    arithm_pair m_GridMinMax;
+    arithm_pair m_GridXRange = arithm_pair(std::nanl("1"), std::nanl("1"));
+    int m_GridStride = 1;
+
+    // Curves of the last pass split at jumps and poles, the first tiles when panning
+    QVector<QVector<QPointF>> m_GridCurves;
+    quint64 m_GridGeneration = 0;
+
+    // Last plotted samples and vertical range
+    QVector<QVector<QPointF>> m_Curves;
+    arithm_pair m_YRange;
+    bool m_isPlotted = false;
+
+    // Drag to pan
+    ArithmTiles m_Tiles;
+    QPoint m_PanOrigin;
+    arithm_pair m_PanRange;
+    double m_PanTileWidth = 0;
+    bool m_isPanning = false;
+
+    // z = f(x, y) field
+    ArithmField m_Field;
+    std::string m_FieldExpression;
+    int m_FieldResolution = PLOT_FIELD_RESOLUTION_DEFAULT;
+    int m_FieldContours = PLOT_FIELD_CONTOURS_DEFAULT;
+
+    // Zeros and intersections of the plotted curves, indices into m_Active
+    QVector<ArithmRoot> m_Roots;
+
+    // Extrema and inflection points, refined ones are kept for the same expression
+    // and reused when a later grid brackets them again
+    QVector<ArithmExtremum> m_Extrema;
+    QVector<ArithmExtremum> m_ExtremaCache;
+    std::string m_ExtremaExpression;
+
+    // Family of curves over k, a single member while scrubbing
+    ArithmSweep m_Sweep;
+    QVector<double> m_SweepValues;
+    int m_SweepFrame = -1;
     QSettings *m_Settings;
 };
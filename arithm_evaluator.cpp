@@ -0,0 +1,47 @@
+#include "arithm_evaluator.h"
+#include "arithm_optimizer.h"
+
+#include <cmath>
+
+ArithmEvaluator::ArithmEvaluator(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                                 ArithmBudget *budget)
+    : m_Names(variables), m_Storage(variables.size(), std::nanl("1"))
+{
+    for(std::size_t i = 0; i < m_Names.size(); i++)
+        m_Symbols.add_variable(m_Names[i], m_Storage[i]);
+
+    m_Symbols.add_constants();
+    m_Optimizer.reset(new ArithmOptimizer(m_Symbols, budget));
+    m_Expression.register_symbol_table(m_Symbols);
+
+    exprtk::parser<arithm_double> parser;
+    if(budget)
+        parser.register_loop_runtime_check(*budget);
+
+    m_isValid = parser.compile(program, m_Expression);
+}
+
+ArithmEvaluator::~ArithmEvaluator()
+{
+}
+
+bool ArithmEvaluator::IsValid() const
+{
+    return m_isValid;
+}
+
+arithm_double *ArithmEvaluator::Variable(const std::string &name)
+{
+    for(std::size_t i = 0; i < m_Names.size(); i++)
+    {
+        if(m_Names[i] == name)
+            return &m_Storage[i];
+    }
+
+    return nullptr;
+}
+
+arithm_double ArithmEvaluator::Value()
+{
+    return m_Expression.value();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "exprtk.hpp"
+#include "arithm_budget.h"
+
+// Exprtk
+typedef long double arithm_double;
+typedef std::pair<arithm_double, arithm_double> arithm_pair;
+
+class ArithmOptimizer;
+
+// Private copy of an expression with its own variable storage, for worker threads
+class ArithmEvaluator
+{
+public:
+    ArithmEvaluator(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                    ArithmBudget *budget = nullptr);
+    ~ArithmEvaluator();
+
+    ArithmEvaluator(const ArithmEvaluator &) = delete;
+    ArithmEvaluator &operator=(const ArithmEvaluator &) = delete;
+
+    bool IsValid() const;
+
+    // Storage bound to the expression, nullptr for unknown names
+    arithm_double *Variable(const std::string &name);
+
+    arithm_double Value();
+
+private:
+    std::vector<std::string> m_Names;
+    std::vector<arithm_double> m_Storage;
+
+    exprtk::symbol_table<arithm_double> m_Symbols;
+    std::unique_ptr<ArithmOptimizer> m_Optimizer;
+    exprtk::expression<arithm_double> m_Expression;
+
+    bool m_isValid = false;
+};
@@ -0,0 +1,166 @@
+#include "arithm_extrema.h"
+#include "arithm_budget.h"
+#include "arithm_task.h"
+#include "settings.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace
+{
+    // Minimum of f on [a, b], reusing one inner point per step
+    double GoldenSection(const std::function<double(double)> &f, double a, double b)
+    {
+        const double ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+
+        double c = b - ratio * (b - a), d = a + ratio * (b - a);
+        double fc = f(c), fd = f(d);
+
+        for(int i = 0; i < PLOT_GOLDEN_ITERATIONS; i++)
+        {
+            if(fc < fd)
+            {
+                b = d;
+                d = c;
+                fd = fc;
+                c = b - ratio * (b - a);
+                fc = f(c);
+            }
+            else
+            {
+                a = c;
+                c = d;
+                fc = fd;
+                d = a + ratio * (b - a);
+                fd = f(d);
+            }
+        }
+
+        return 0.5 * (a + b);
+    }
+}
+
+ArithmExtrema::ArithmExtrema(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                             const std::vector<std::string> &curves)
+    : m_Program(program), m_Variables(variables), m_Curves(curves)
+{
+}
+
+void ArithmExtrema::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+QVector<ArithmExtremum> ArithmExtrema::Find(const QVector<ArithmExtremumBracket> &brackets, double h) const
+{
+    QVector<ArithmExtremum> points(brackets.size());
+    QVector<bool> isFound(brackets.size(), false);
+
+    // Every thread takes every n-th candidate on its own expression copy
+    QThreadPool pool;
+    const int tasks = qMin(brackets.size(), qMax(1, QThread::idealThreadCount()));
+
+    // One deadline for all threads, the one of the calling evaluation if already started
+    ArithmBudget budget(m_Budget);
+    budget.resume();
+
+    for(int task = 0; task < tasks; task++)
+    {
+        pool.start(new ArithmTask([&, task, tasks]()
+        {
+            ArithmEvaluator evaluator(m_Program, m_Variables, &budget);
+            arithm_double *x = evaluator.Variable("x");
+
+            if(!evaluator.IsValid() || !x)
+                return;
+
+            std::vector<arithm_double*> curves;
+            for(const std::string &name : m_Curves)
+                curves.push_back(name.empty() ? nullptr : evaluator.Variable(name));
+
+            for(int i = task; i < brackets.size(); i += tasks)
+            {
+                const ArithmExtremumBracket &bracket = brackets[i];
+
+                auto value = [&](double at) -> double
+                {
+                    budget.checkpoint();
+
+                    *x = at;
+                    const arithm_double result = evaluator.Value();
+
+                    return double(curves[bracket.curve] ? *curves[bracket.curve] : result);
+                };
+
+                try
+                {
+                    const double fa = value(bracket.a);
+                    const double fb = value(bracket.b);
+                    double at;
+
+                    if(bracket.kind == ArithmExtremum::Inflection)
+                    {
+                        // Bisect on the sign of the second difference
+                        auto curvature = [&](double c) { return value(c + h) - 2.0 * value(c) + value(c - h); };
+
+                        double a = bracket.a, b = bracket.b;
+                        const bool isConvex = curvature(a) > 0;
+
+                        for(int k = 0; k < PLOT_GOLDEN_ITERATIONS && b - a > 2.0 * h; k++)
+                        {
+                            const double m = 0.5 * (a + b);
+                            if((curvature(m) > 0) == isConvex)
+                                a = m;
+                            else
+                                b = m;
+                        }
+
+                        at = 0.5 * (a + b);
+                    }
+                    else
+                    {
+                        const double sign = bracket.kind == ArithmExtremum::Minimum ? 1.0 : -1.0;
+                        at = GoldenSection([&](double c) { return sign * value(c); }, bracket.a, bracket.b);
+                    }
+
+                    const double y = value(at);
+                    if(!std::isfinite(y))
+                        continue;
+
+                    // Searches across a pole or a jump end up at the edge of the bracket
+                    const double margin = PLOT_EXTREMUM_MARGIN * (bracket.b - bracket.a);
+                    if(bracket.kind != ArithmExtremum::Inflection && (at - bracket.a < margin || bracket.b - at < margin))
+                        continue;
+
+                    // Inflection points lie between their neighbours, poles do not
+                    const double spread = std::abs(fb - fa);
+                    if(bracket.kind == ArithmExtremum::Inflection &&
+                            (y < std::min(fa, fb) - spread || y > std::max(fa, fb) + spread))
+                        continue;
+
+                    points[i] = ArithmExtremum{ at, y, bracket.curve, bracket.kind };
+                    isFound[i] = true;
+                }
+                catch(const std::runtime_error &)
+                {
+                    // Budget exhausted, drop the remaining candidates of this thread
+                    break;
+                }
+            }
+        }));
+    }
+
+    pool.waitForDone();
+
+    QVector<ArithmExtremum> result;
+    for(int i = 0; i < points.size(); i++)
+    {
+        if(isFound[i])
+            result.append(points[i]);
+    }
+
+    return result;
+}
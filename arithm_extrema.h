@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QVector>
+
+#include "arithm_evaluator.h"
+
+struct ArithmExtremum
+{
+    enum Kind { Minimum, Maximum, Inflection };
+
+    double x, y;
+    int curve;
+    Kind kind;
+};
+
+// Candidate from the sample grid, the extremum or inflection lies between a and b
+struct ArithmExtremumBracket
+{
+    double a, b;
+    int curve;
+    ArithmExtremum::Kind kind;
+};
+
+// Golden-section search for extrema and bisection on the second difference for
+// inflection points, one expression copy per thread
+class ArithmExtrema
+{
+public:
+    // Curve names are read after each evaluation, an empty name stands for the result
+    ArithmExtrema(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                  const std::vector<std::string> &curves);
+
+    void SetBudget(const ArithmBudget *budget);
+
+    // Refined points in bracket order, candidates at poles and jumps are dropped.
+    // The second difference of inflection points is taken with step h.
+    QVector<ArithmExtremum> Find(const QVector<ArithmExtremumBracket> &brackets, double h) const;
+
+private:
+    exprtk::token_program m_Program;
+    std::vector<std::string> m_Variables;
+    std::vector<std::string> m_Curves;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
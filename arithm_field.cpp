@@ -0,0 +1,335 @@
+#include "arithm_field.h"
+#include "arithm_budget.h"
+#include "arithm_task.h"
+
+#include <QColor>
+#include <QMutexLocker>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Snap cell sizes to powers of two, so that nearby zoom levels share tiles
+    double CellSize(double raw)
+    {
+        return std::pow(2.0, std::ceil(std::log2(raw)));
+    }
+
+    // Cell indices stay exact in a double and far from overflowing qint64
+    const double MAX_CELL_INDEX = 4503599627370496.0;
+
+    qint64 FloorDiv(qint64 a, qint64 b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    // Perceptually ordered colour map (dark blue, teal, green, yellow)
+    QRgb ColorMap(float t)
+    {
+        static const QColor stops[] = { QColor(68, 1, 84), QColor(59, 82, 139), QColor(33, 145, 140),
+                                        QColor(94, 201, 98), QColor(253, 231, 37) };
+        const int count = sizeof(stops) / sizeof(stops[0]) - 1;
+
+        const float s = qBound(0.0f, t, 1.0f) * count;
+        const int i = qMin(int(s), count - 1);
+        const float f = s - i;
+
+        return qRgb(int(stops[i].red() + f * (stops[i + 1].red() - stops[i].red())),
+                    int(stops[i].green() + f * (stops[i + 1].green() - stops[i].green())),
+                    int(stops[i].blue() + f * (stops[i + 1].blue() - stops[i].blue())));
+    }
+}
+
+uint qHash(const ArithmField::TileKey &key, uint seed)
+{
+    return qHash(key.cellWidth, seed) ^ qHash(key.cellHeight, seed) ^ qHash(key.column, seed) ^ (qHash(key.row, seed) << 1);
+}
+
+ArithmField::ArithmField(QObject *parent)
+    : QObject(parent), m_Generation(0)
+{
+}
+
+ArithmField::~ArithmField()
+{
+    m_Generation++;
+    m_Pool.clear();
+    m_Pool.waitForDone();
+}
+
+void ArithmField::Reset(const exprtk::token_program &program, const std::vector<std::string> &variables)
+{
+    m_Pool.clear();
+
+    std::shared_ptr<Config> config = std::make_shared<Config>();
+    config->program = program;
+    config->variables = variables;
+    config->generation = ++m_Generation;
+
+    QMutexLocker locker(&m_Mutex);
+    m_Config = config;
+    m_Tiles.clear();
+    m_Pending.clear();
+    m_Recent.clear();
+}
+
+void ArithmField::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+bool ArithmField::Sample(const QRectF &range, const QSize &viewport, int pixelSize,
+                         QVector<float> &z, QSize &size, QRectF &extent)
+{
+    size = QSize();
+    extent = QRectF();
+    z.clear();
+
+    // Empty or degenerate ranges (e.g. x_min = x_max) have no cells
+    if(!std::isfinite(range.width()) || !std::isfinite(range.height()) || !(range.width() > 0) || !(range.height() > 0))
+        return true;
+
+    const double cellWidth = CellSize(range.width() * pixelSize / qMax(1, viewport.width()));
+    const double cellHeight = CellSize(range.height() * pixelSize / qMax(1, viewport.height()));
+
+    // Cells out of range, or too small for the magnitude of the coordinates
+    if(!std::isfinite(cellWidth) || !std::isfinite(cellHeight) || !(cellWidth > 0) || !(cellHeight > 0) ||
+       !(std::abs(range.left()) / cellWidth < MAX_CELL_INDEX) || !(std::abs(range.right()) / cellWidth < MAX_CELL_INDEX) ||
+       !(std::abs(range.top()) / cellHeight < MAX_CELL_INDEX) || !(std::abs(range.bottom()) / cellHeight < MAX_CELL_INDEX))
+        return true;
+
+    const qint64 column0 = qint64(std::floor(range.left() / cellWidth));
+    const qint64 column1 = qint64(std::ceil(range.right() / cellWidth));
+    const qint64 row0 = qint64(std::floor(range.top() / cellHeight));
+    const qint64 row1 = qint64(std::ceil(range.bottom() / cellHeight));
+
+    size = QSize(int(column1 - column0), int(row1 - row0));
+    extent = QRectF(column0 * cellWidth, row0 * cellHeight, size.width() * cellWidth, size.height() * cellHeight);
+    z.fill(std::numeric_limits<float>::quiet_NaN(), size.width() * size.height());
+
+    bool isComplete = true;
+
+    QMutexLocker locker(&m_Mutex);
+
+    // Keep every visible tile plus a ring around it
+    const qint64 tilesX = FloorDiv(column1 - 1, TILE_SIZE) - FloorDiv(column0, TILE_SIZE) + 1;
+    const qint64 tilesY = FloorDiv(row1 - 1, TILE_SIZE) - FloorDiv(row0, TILE_SIZE) + 1;
+    m_Capacity = int(qMax<qint64>(64, 2 * (tilesX + 2) * (tilesY + 2)));
+
+    for(qint64 tileRow = FloorDiv(row0, TILE_SIZE); tileRow <= FloorDiv(row1 - 1, TILE_SIZE); tileRow++)
+    {
+        for(qint64 tileColumn = FloorDiv(column0, TILE_SIZE); tileColumn <= FloorDiv(column1 - 1, TILE_SIZE); tileColumn++)
+        {
+            const TileKey key = { cellWidth, cellHeight, tileColumn, tileRow };
+
+            auto it = m_Tiles.constFind(key);
+            if(it == m_Tiles.constEnd())
+            {
+                isComplete = false;
+                Request(key);
+                continue;
+            }
+
+            m_Recent.removeOne(key);
+            m_Recent.append(key);
+
+            // Copy the overlap, image rows run from the top (largest y) down
+            const QVector<float> &tile = *it;
+            for(int r = 0; r < TILE_SIZE; r++)
+            {
+                const qint64 row = tileRow * TILE_SIZE + r;
+                if(row < row0 || row >= row1)
+                    continue;
+
+                for(int c = 0; c < TILE_SIZE; c++)
+                {
+                    const qint64 column = tileColumn * TILE_SIZE + c;
+                    if(column < column0 || column >= column1)
+                        continue;
+
+                    z[int((row1 - 1 - row) * size.width() + (column - column0))] = tile[r * TILE_SIZE + c];
+                }
+            }
+        }
+    }
+
+    return isComplete;
+}
+
+void ArithmField::Request(const TileKey &key)
+{
+    if(!m_Config || m_Pending.contains(key))
+        return;
+
+    m_Pending.insert(key);
+
+    std::shared_ptr<const Config> config = m_Config;
+    m_Pool.start(new ArithmTask([this, config, key]() { Compute(config, key); }));
+}
+
+void ArithmField::Compute(std::shared_ptr<const Config> config, TileKey key)
+{
+    if(config->generation != m_Generation)
+        return;
+
+    ArithmBudget budget(m_Budget);
+
+    ArithmEvaluator evaluator(config->program, config->variables, &budget);
+    arithm_double *x = evaluator.Variable("x");
+    arithm_double *y = evaluator.Variable("y");
+
+    QVector<float> tile(TILE_SIZE * TILE_SIZE, std::numeric_limits<float>::quiet_NaN());
+
+    if(evaluator.IsValid() && x && y)
+    {
+        budget.start();
+
+        try
+        {
+            for(int r = 0; r < TILE_SIZE; r++)
+            {
+                if(config->generation != m_Generation)
+                    return;
+
+                *y = (key.row * TILE_SIZE + r + 0.5) * key.cellHeight;
+
+                for(int c = 0; c < TILE_SIZE; c++)
+                {
+                    budget.checkpoint();
+
+                    *x = (key.column * TILE_SIZE + c + 0.5) * key.cellWidth;
+                    tile[r * TILE_SIZE + c] = float(evaluator.Value());
+                }
+            }
+        }
+        catch(const std::runtime_error &)
+        {
+            // Keep the partial tile, so that an exhausted budget is not retried,
+            // unless it was cancelled and has to be computed again on request
+            if(budget.isCancelled())
+            {
+                QMutexLocker locker(&m_Mutex);
+                if(config->generation == m_Generation)
+                    m_Pending.remove(key);
+                return;
+            }
+        }
+    }
+
+    QMutexLocker locker(&m_Mutex);
+
+    if(config->generation != m_Generation)
+        return;
+
+    m_Pending.remove(key);
+    m_Tiles.insert(key, tile);
+    m_Recent.append(key);
+
+    while(m_Recent.size() > m_Capacity)
+        m_Tiles.remove(m_Recent.takeFirst());
+
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, "TileReady", Qt::QueuedConnection);
+}
+
+QImage ArithmField::Colorize(const QVector<float> &z, const QSize &size)
+{
+    float zMin = std::numeric_limits<float>::max();
+    float zMax = -std::numeric_limits<float>::max();
+
+    for(float value : z)
+    {
+        if(std::isfinite(value))
+        {
+            zMin = qMin(zMin, value);
+            zMax = qMax(zMax, value);
+        }
+    }
+
+    const float scale = zMax > zMin ? 1.0f / (zMax - zMin) : 0.0f;
+
+    QImage image(size, QImage::Format_ARGB32);
+    for(int r = 0; r < size.height(); r++)
+    {
+        QRgb *line = reinterpret_cast<QRgb*>(image.scanLine(r));
+        for(int c = 0; c < size.width(); c++)
+        {
+            const float value = z[r * size.width() + c];
+            line[c] = std::isfinite(value) ? ColorMap((value - zMin) * scale) : qRgba(0, 0, 0, 0);
+        }
+    }
+
+    return image;
+}
+
+QVector<QLineF> ArithmField::Contours(const QVector<float> &z, const QSize &size, const QRectF &extent, int levels)
+{
+    QVector<QLineF> lines;
+
+    float zMin = std::numeric_limits<float>::max();
+    float zMax = -std::numeric_limits<float>::max();
+
+    for(float value : z)
+    {
+        if(std::isfinite(value))
+        {
+            zMin = qMin(zMin, value);
+            zMax = qMax(zMax, value);
+        }
+    }
+
+    if(!(zMax > zMin) || levels <= 0 || size.width() < 2 || size.height() < 2)
+        return lines;
+
+    const double cellWidth = extent.width() / size.width();
+    const double cellHeight = extent.height() / size.height();
+
+    // Cell centres in data coordinates, row 0 at the top
+    auto point = [&](double c, double r)
+    {
+        return QPointF(extent.left() + (c + 0.5) * cellWidth, extent.bottom() - (r + 0.5) * cellHeight);
+    };
+
+    for(int level = 1; level <= levels; level++)
+    {
+        const float iso = zMin + (zMax - zMin) * level / (levels + 1);
+
+        // Marching squares, one or two segments per cell with mixed corner signs
+        for(int r = 0; r + 1 < size.height(); r++)
+        {
+            for(int c = 0; c + 1 < size.width(); c++)
+            {
+                const float v[4] = { z[r * size.width() + c], z[r * size.width() + c + 1],
+                                     z[(r + 1) * size.width() + c + 1], z[(r + 1) * size.width() + c] };
+
+                if(!std::isfinite(v[0]) || !std::isfinite(v[1]) || !std::isfinite(v[2]) || !std::isfinite(v[3]))
+                    continue;
+
+                // Corners 0..3 clockwise from the top left, crossings on edges 0..3
+                const double corners[4][2] = { { double(c), double(r) }, { c + 1.0, double(r) }, { c + 1.0, r + 1.0 }, { double(c), r + 1.0 } };
+
+                QPointF crossings[4];
+                int count = 0;
+
+                for(int e = 0; e < 4; e++)
+                {
+                    const float a = v[e];
+                    const float b = v[(e + 1) % 4];
+
+                    if((a < iso) == (b < iso))
+                        continue;
+
+                    const double t = (iso - a) / (b - a);
+                    crossings[count++] = point(corners[e][0] + t * (corners[(e + 1) % 4][0] - corners[e][0]),
+                                               corners[e][1] + t * (corners[(e + 1) % 4][1] - corners[e][1]));
+                }
+
+                for(int i = 0; i + 1 < count; i += 2)
+                    lines.append(QLineF(crossings[i], crossings[i + 1]));
+            }
+        }
+    }
+
+    return lines;
+}
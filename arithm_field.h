@@ -0,0 +1,83 @@
+#pragma once
+
+#include <QHash>
+#include <QImage>
+#include <QLineF>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QRectF>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "arithm_evaluator.h"
+
+// Tiled z = f(x, y) grid, sampled on demand by a thread pool
+class ArithmField : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Cells per tile side, a tile of floats fits comfortably into L1
+    static const int TILE_SIZE = 64;
+
+    explicit ArithmField(QObject *parent = nullptr);
+    ~ArithmField();
+
+    void Reset(const exprtk::token_program &program, const std::vector<std::string> &variables);
+    void SetBudget(const ArithmBudget *budget);
+
+    // Cells of the visible range, at most one per pixelSize pixels of the viewport,
+    // NaN where tiles are still being computed. Returns false if any are missing.
+    // Degenerate ranges give an empty grid.
+    bool Sample(const QRectF &range, const QSize &viewport, int pixelSize,
+                QVector<float> &z, QSize &size, QRectF &extent);
+
+    static QImage Colorize(const QVector<float> &z, const QSize &size);
+    static QVector<QLineF> Contours(const QVector<float> &z, const QSize &size, const QRectF &extent, int levels);
+
+signals:
+    void TileReady();
+
+private:
+    struct Config
+    {
+        exprtk::token_program program;
+        std::vector<std::string> variables;
+        quint64 generation;
+    };
+
+    struct TileKey
+    {
+        double cellWidth, cellHeight;
+        qint64 column, row;
+
+        bool operator==(const TileKey &other) const
+        {
+            return cellWidth == other.cellWidth && cellHeight == other.cellHeight &&
+                   column == other.column && row == other.row;
+        }
+    };
+
+    friend uint qHash(const TileKey &key, uint seed);
+
+    void Request(const TileKey &key);
+    void Compute(std::shared_ptr<const Config> config, TileKey key);
+
+private:
+    QThreadPool m_Pool;
+
+    QMutex m_Mutex;
+    QHash<TileKey, QVector<float>> m_Tiles;
+    QSet<TileKey> m_Pending;
+    QList<TileKey> m_Recent;
+    int m_Capacity = 64;
+
+    std::shared_ptr<const Config> m_Config;
+    std::atomic<quint64> m_Generation;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -0,0 +1,199 @@
+#include "arithm_history.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QLockFile>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace
+{
+    const int LOCK_TIMEOUT = 1000;
+
+    QByteArray Escape(const QString &expression)
+    {
+        QByteArray result;
+        for(const char c : expression.toUtf8())
+        {
+            if(c == '\\') result += "\\\\";
+            else if(c == '\n') result += "\\n";
+            else if(c == '\t') result += "\\t";
+            else result += c;
+        }
+
+        return result;
+    }
+
+    QString Unescape(const QByteArray &text)
+    {
+        QByteArray result;
+        for(int i = 0; i < text.size(); i++)
+        {
+            if(text[i] == '\\' && i + 1 < text.size())
+            {
+                i++;
+                result += text[i] == 'n' ? '\n' : text[i] == 't' ? '\t' : text[i];
+            }
+            else
+                result += text[i];
+        }
+
+        return QString::fromUtf8(result);
+    }
+
+    QByteArray Record(qint64 timestamp, int count, const QString &expression)
+    {
+        return QByteArray::number(timestamp) + '\t' + QByteArray::number(count) + '\t' + Escape(expression) + '\n';
+    }
+}
+
+void ArithmHistory::SetFileName(const QString &fileName)
+{
+    m_FileName = fileName;
+}
+
+bool ArithmHistory::Exists() const
+{
+    return QFile::exists(m_FileName);
+}
+
+bool ArithmHistory::Append(const QString &expression)
+{
+    if(expression.isEmpty())
+        return false;
+
+    // Only excludes a concurrent compaction, appends themselves rely on O_APPEND
+    QLockFile lock(m_FileName + ".lock");
+    if(!lock.tryLock(LOCK_TIMEOUT))
+        return false;
+
+    QFile file(m_FileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered))
+        return false;
+
+    const QByteArray record = Record(QDateTime::currentMSecsSinceEpoch(), 1, expression);
+
+    return file.write(record) == record.size();
+}
+
+bool ArithmHistory::Import(const QStringList &expressions)
+{
+    QLockFile lock(m_FileName + ".lock");
+    if(!lock.tryLock(LOCK_TIMEOUT) || Exists())
+        return false;
+
+    // Oldest first, so that the most recent entry gets the newest timestamp
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<ArithmHistoryEntry> entries;
+    for(int i = 0; i < expressions.size(); i++)
+    {
+        ArithmHistoryEntry entry;
+        entry.expression = expressions[i];
+        entry.timestamp = now - i;
+        entry.count = 1;
+        entries.prepend(entry);
+    }
+
+    return Write(entries);
+}
+
+QVector<ArithmHistoryEntry> ArithmHistory::Load(int limit)
+{
+    QVector<ArithmHistoryEntry> entries;
+    const int records = Read(entries);
+
+    std::sort(entries.begin(), entries.end(), [](const ArithmHistoryEntry &a, const ArithmHistoryEntry &b)
+    {
+        return a.timestamp > b.timestamp;
+    });
+
+    if(entries.size() > limit)
+        entries.resize(limit);
+
+    if(records > 2 * limit)
+    {
+        QLockFile lock(m_FileName + ".lock");
+        if(lock.tryLock(0))
+        {
+            // Re-read under the lock to keep records appended in the meantime
+            QVector<ArithmHistoryEntry> current;
+            Read(current);
+
+            std::sort(current.begin(), current.end(), [](const ArithmHistoryEntry &a, const ArithmHistoryEntry &b)
+            {
+                return a.timestamp < b.timestamp;
+            });
+
+            if(current.size() > limit)
+                current.erase(current.begin(), current.end() - limit);
+
+            Write(current);
+        }
+    }
+
+    return entries;
+}
+
+int ArithmHistory::Read(QVector<ArithmHistoryEntry> &entries) const
+{
+    QFile file(m_FileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    QHash<QString, int> index;
+    int records = 0;
+
+    while(!file.atEnd())
+    {
+        const QByteArray line = file.readLine();
+
+        // Skip torn records of an instance that died while writing
+        if(!line.endsWith('\n'))
+            break;
+
+        const int first = line.indexOf('\t');
+        const int second = first < 0 ? -1 : line.indexOf('\t', first + 1);
+        if(second < 0)
+            continue;
+
+        records++;
+
+        const QString expression = Unescape(line.mid(second + 1, line.size() - second - 2));
+        const qint64 timestamp = line.left(first).toLongLong();
+        const int count = qMax(1, line.mid(first + 1, second - first - 1).toInt());
+
+        auto it = index.constFind(expression);
+        if(it == index.constEnd())
+        {
+            ArithmHistoryEntry entry;
+            entry.expression = expression;
+            entry.timestamp = timestamp;
+            entry.count = count;
+
+            index.insert(expression, entries.size());
+            entries.append(entry);
+        }
+        else
+        {
+            ArithmHistoryEntry &entry = entries[*it];
+            entry.timestamp = qMax(entry.timestamp, timestamp);
+            entry.count += count;
+        }
+    }
+
+    return records;
+}
+
+bool ArithmHistory::Write(const QVector<ArithmHistoryEntry> &entries) const
+{
+    QSaveFile file(m_FileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    for(const ArithmHistoryEntry &entry : entries)
+        file.write(Record(entry.timestamp, entry.count, entry.expression));
+
+    return file.commit();
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct ArithmHistoryEntry
+{
+    QString expression;
+    qint64 timestamp = 0;
+    int count = 0;
+};
+
+// Append-only history journal shared by concurrent Arithm instances
+class ArithmHistory
+{
+public:
+    void SetFileName(const QString &fileName);
+    bool Exists() const;
+
+    // One record per evaluation, appended with a single write
+    bool Append(const QString &expression);
+    bool Import(const QStringList &expressions);
+
+    // Most recent first, compacting the journal once it grew past twice the limit
+    QVector<ArithmHistoryEntry> Load(int limit);
+
+private:
+    int Read(QVector<ArithmHistoryEntry> &entries) const;
+    bool Write(const QVector<ArithmHistoryEntry> &entries) const;
+
+private:
+    QString m_FileName;
+};
@@ -0,0 +1,197 @@
+#include "arithm_history_index.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int FETCH_CHUNK = 256;
+
+    quint64 Trigram(const QString &text, int i)
+    {
+        return (quint64(text[i].unicode()) << 32) | (quint64(text[i + 1].unicode()) << 16) | quint64(text[i + 2].unicode());
+    }
+
+    bool IsSubsequence(const QString &query, const QString &text)
+    {
+        int j = 0;
+        for(int i = 0; i < text.size() && j < query.size(); i++)
+        {
+            if(text[i] == query[j])
+                j++;
+        }
+
+        return j == query.size();
+    }
+}
+
+void ArithmHistoryIndex::SetEntries(const QVector<ArithmHistoryEntry> &entries)
+{
+    m_Entries = entries;
+    m_Folded.clear();
+    m_Trigrams.clear();
+    m_isBuilt = false;
+}
+
+const QVector<ArithmHistoryEntry> &ArithmHistoryIndex::Entries() const
+{
+    return m_Entries;
+}
+
+QStringList ArithmHistoryIndex::Match(const QString &query, int limit)
+{
+    QStringList result;
+
+    const QString folded = query.toCaseFolded();
+    if(folded.isEmpty() || limit <= 0)
+        return result;
+
+    Build();
+
+    QVector<int> candidates;
+
+    if(folded.size() < 3)
+    {
+        for(int i = 0; i < m_Entries.size(); i++)
+        {
+            if(m_Folded[i].contains(folded))
+                candidates.append(i);
+        }
+    }
+    else
+    {
+        // Intersect postings, starting with the rarest trigram
+        QVector<const QVector<int>*> postings;
+        for(int i = 0; i + 2 < folded.size(); i++)
+        {
+            auto it = m_Trigrams.constFind(Trigram(folded, i));
+            if(it == m_Trigrams.constEnd())
+            {
+                postings.clear();
+                break;
+            }
+
+            postings.append(&*it);
+        }
+
+        if(!postings.isEmpty())
+        {
+            std::sort(postings.begin(), postings.end(), [](const QVector<int> *a, const QVector<int> *b)
+            {
+                return a->size() < b->size();
+            });
+
+            for(int i : *postings[0])
+            {
+                if(m_Folded[i].contains(folded))
+                    candidates.append(i);
+            }
+        }
+    }
+
+    if(candidates.size() < limit)
+    {
+        for(int i = 0; i < m_Entries.size() && candidates.size() < limit; i++)
+        {
+            if(!m_Folded[i].contains(folded) && IsSubsequence(folded, m_Folded[i]))
+                candidates.append(i);
+        }
+    }
+
+    QVector<QPair<double, int>> ranked;
+    ranked.reserve(candidates.size());
+    for(int i : candidates)
+        ranked.append(qMakePair(Score(i, folded), i));
+
+    const int count = qMin(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [](const QPair<double, int> &a, const QPair<double, int> &b)
+    {
+        return a.first > b.first;
+    });
+
+    for(int i = 0; i < count; i++)
+        result << m_Entries[ranked[i].second].expression;
+
+    return result;
+}
+
+void ArithmHistoryIndex::Build()
+{
+    if(m_isBuilt)
+        return;
+
+    m_Folded.reserve(m_Entries.size());
+    for(const ArithmHistoryEntry &entry : m_Entries)
+        m_Folded.append(entry.expression.toCaseFolded());
+
+    for(int i = 0; i < m_Folded.size(); i++)
+    {
+        const QString &text = m_Folded[i];
+        for(int j = 0; j + 2 < text.size(); j++)
+        {
+            QVector<int> &posting = m_Trigrams[Trigram(text, j)];
+
+            // Entries are visited in order, so a repeated trigram is always last
+            if(posting.isEmpty() || posting.last() != i)
+                posting.append(i);
+        }
+    }
+
+    m_isBuilt = true;
+}
+
+double ArithmHistoryIndex::Score(int i, const QString &query) const
+{
+    // Entries are sorted most recent first
+    double score = std::log2(1.0 + m_Entries[i].count) - std::log2(1.0 + i);
+
+    if(m_Folded[i].startsWith(query))
+        score += 2.0;
+    else if(!m_Folded[i].contains(query))
+        score -= 4.0;
+
+    return score;
+}
+
+void ArithmHistoryModel::SetItems(const QStringList &items)
+{
+    beginResetModel();
+    m_Items = items;
+    m_Fetched = qMin(FETCH_CHUNK, m_Items.size());
+    endResetModel();
+}
+
+int ArithmHistoryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_Fetched;
+}
+
+QVariant ArithmHistoryModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_Fetched)
+        return QVariant();
+
+    if(role == Qt::DisplayRole || role == Qt::EditRole)
+        return m_Items[index.row()];
+
+    return QVariant();
+}
+
+bool ArithmHistoryModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_Fetched < m_Items.size();
+}
+
+void ArithmHistoryModel::fetchMore(const QModelIndex &parent)
+{
+    if(parent.isValid())
+        return;
+
+    const int count = qMin(FETCH_CHUNK, m_Items.size() - m_Fetched);
+    if(count <= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), m_Fetched, m_Fetched + count - 1);
+    m_Fetched += count;
+    endInsertRows();
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include "arithm_history.h"
+
+// Trigram index over history entries, ranked by recency and frequency
+class ArithmHistoryIndex
+{
+public:
+    void SetEntries(const QVector<ArithmHistoryEntry> &entries);
+    const QVector<ArithmHistoryEntry> &Entries() const;
+
+    // Substring matches, falling back to subsequence matches for typos and gaps
+    QStringList Match(const QString &query, int limit);
+
+private:
+    void Build();
+    double Score(int i, const QString &query) const;
+
+private:
+    QVector<ArithmHistoryEntry> m_Entries;
+    QVector<QString> m_Folded;
+
+    // Built on the first query long enough to use it
+    QHash<quint64, QVector<int>> m_Trigrams;
+    bool m_isBuilt = false;
+};
+
+// List model that hands its rows to views in chunks as they scroll
+class ArithmHistoryModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    using QAbstractListModel::QAbstractListModel;
+
+    void SetItems(const QStringList &items);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    QStringList m_Items;
+    int m_Fetched = 0;
+};
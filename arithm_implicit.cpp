@@ -0,0 +1,276 @@
+#include "arithm_implicit.h"
+#include "arithm_budget.h"
+#include "arithm_task.h"
+
+#include <QHash>
+#include <QLineF>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Walks one subtree, cells are addressed in units of the finest level
+    class Tracer
+    {
+    public:
+        Tracer(ArithmEvaluator &evaluator, const std::string &name, ArithmBudget &budget,
+               const QRectF &range, int minDepth, int maxDepth)
+            : m_Evaluator(evaluator), m_Budget(budget), m_Range(range), m_MinDepth(minDepth), m_MaxDepth(maxDepth)
+        {
+            m_X = evaluator.Variable("x");
+            m_Y = evaluator.Variable("y");
+            m_Z = evaluator.Variable(name);
+
+            const double cells = std::ldexp(1.0, maxDepth);
+            m_UnitX = range.width() / cells;
+            m_UnitY = range.height() / cells;
+        }
+
+        bool IsValid() const
+        {
+            return m_X && m_Y && m_Z;
+        }
+
+        double F(qint64 ix, qint64 iy)
+        {
+            m_Budget.checkpoint();
+
+            *m_X = m_Range.left() + ix * m_UnitX;
+            *m_Y = m_Range.top() + iy * m_UnitY;
+            m_Evaluator.Value();
+
+            return double(*m_Z);
+        }
+
+        void Visit(qint64 ix, qint64 iy, qint64 size, int depth, double f00, double f10, double f11, double f01)
+        {
+            if(depth == m_MaxDepth)
+            {
+                Emit(ix, iy, size, f00, f10, f11, f01);
+                return;
+            }
+
+            const qint64 half = size / 2;
+            const double c = F(ix + half, iy + half);
+
+            // Without a sign change, skip cells whose centre value exceeds the
+            // variation across the cell, a cheap stand-in for an interval enclosure
+            if(depth >= m_MinDepth)
+            {
+                const double values[5] = { f00, f10, f11, f01, c };
+
+                bool isMixed = false, isFinite = true;
+                double variation = 0;
+
+                for(double value : values)
+                {
+                    isFinite = isFinite && std::isfinite(value);
+                    isMixed = isMixed || (value < 0) != (c < 0);
+                    variation = std::max(variation, std::abs(value - c));
+                }
+
+                if(!isFinite || (!isMixed && std::abs(c) > variation))
+                    return;
+            }
+
+            const double b = F(ix + half, iy);
+            const double r = F(ix + size, iy + half);
+            const double t = F(ix + half, iy + size);
+            const double l = F(ix, iy + half);
+
+            Visit(ix, iy, half, depth + 1, f00, b, c, l);
+            Visit(ix + half, iy, half, depth + 1, b, f10, r, c);
+            Visit(ix + half, iy + half, half, depth + 1, c, r, f11, t);
+            Visit(ix, iy + half, half, depth + 1, l, c, t, f01);
+        }
+
+        QVector<QLineF> m_Lines;
+
+    private:
+        QPointF Point(qint64 ix, qint64 iy) const
+        {
+            return QPointF(m_Range.left() + ix * m_UnitX, m_Range.top() + iy * m_UnitY);
+        }
+
+        void Emit(qint64 ix, qint64 iy, qint64 size, double f00, double f10, double f11, double f01)
+        {
+            const qint64 corners[4][2] = { { ix, iy }, { ix + size, iy }, { ix + size, iy + size }, { ix, iy + size } };
+            const double values[4] = { f00, f10, f11, f01 };
+
+            QPointF crossings[4];
+            int count = 0;
+
+            for(int e = 0; e < 4; e++)
+            {
+                int a = e, b = (e + 1) % 4;
+
+                if(!std::isfinite(values[a]) || !std::isfinite(values[b]) || (values[a] < 0) == (values[b] < 0))
+                    continue;
+
+                // Interpolate in a fixed direction, so that neighbours produce identical points
+                if(corners[b][0] < corners[a][0] || corners[b][1] < corners[a][1])
+                    std::swap(a, b);
+
+                const double s = values[a] / (values[a] - values[b]);
+                const QPointF pa = Point(corners[a][0], corners[a][1]);
+                const QPointF pb = Point(corners[b][0], corners[b][1]);
+
+                crossings[count++] = pa + s * (pb - pa);
+            }
+
+            for(int i = 0; i + 1 < count; i += 2)
+                m_Lines.append(QLineF(crossings[i], crossings[i + 1]));
+        }
+
+    private:
+        ArithmEvaluator &m_Evaluator;
+        ArithmBudget &m_Budget;
+
+        arithm_double *m_X, *m_Y, *m_Z;
+
+        QRectF m_Range;
+        int m_MinDepth, m_MaxDepth;
+        double m_UnitX, m_UnitY;
+    };
+
+    // Joins segments sharing end points into polylines
+    QVector<QPointF> Chain(const QVector<QLineF> &lines, double tolerance)
+    {
+        typedef QPair<qint64, qint64> Key;
+
+        auto key = [tolerance](const QPointF &point)
+        {
+            return Key(qint64(std::floor(point.x() / tolerance)), qint64(std::floor(point.y() / tolerance)));
+        };
+
+        QMultiHash<Key, int> ends;
+        for(int i = 0; i < lines.size(); i++)
+        {
+            ends.insert(key(lines[i].p1()), i);
+            ends.insert(key(lines[i].p2()), i);
+        }
+
+        QVector<bool> used(lines.size(), false);
+        QVector<QPointF> result;
+
+        auto next = [&](const QPointF &point) -> int
+        {
+            for(int index : ends.values(key(point)))
+            {
+                if(!used[index])
+                    return index;
+            }
+
+            return -1;
+        };
+
+        for(int i = 0; i < lines.size(); i++)
+        {
+            if(used[i])
+                continue;
+
+            used[i] = true;
+            QVector<QPointF> polyline;
+            polyline << lines[i].p1() << lines[i].p2();
+
+            // Extend forwards, then backwards
+            for(int direction = 0; direction < 2; direction++)
+            {
+                for(int j = next(polyline.last()); j >= 0; j = next(polyline.last()))
+                {
+                    used[j] = true;
+                    const bool isForward = key(lines[j].p1()) == key(polyline.last());
+                    polyline.append(isForward ? lines[j].p2() : lines[j].p1());
+                }
+
+                std::reverse(polyline.begin(), polyline.end());
+            }
+
+            if(!result.isEmpty())
+                result.append(QPointF(0.0, std::nan("1")));
+            result += polyline;
+        }
+
+        return result;
+    }
+}
+
+ArithmImplicit::ArithmImplicit(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                               const std::string &name)
+    : m_Program(program), m_Variables(variables), m_Name(name)
+{
+}
+
+void ArithmImplicit::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+QVector<QPointF> ArithmImplicit::Trace(const QRectF &range, int minDepth, int maxDepth) const
+{
+    minDepth = qBound(0, minDepth, maxDepth);
+
+    const qint64 roots = qint64(1) << minDepth;
+    const qint64 size = qint64(1) << (maxDepth - minDepth);
+
+    QVector<QLineF> lines;
+    QMutex mutex;
+
+    // Bands of root cells, each on its own expression copy
+    QThreadPool pool;
+    const int bands = int(qMin<qint64>(roots, qMax(1, QThread::idealThreadCount()) * 4));
+
+    // One deadline for all bands, the one of the calling evaluation if already started
+    ArithmBudget budget(m_Budget);
+    budget.resume();
+
+    for(int band = 0; band < bands; band++)
+    {
+        pool.start(new ArithmTask([&, band]()
+        {
+            ArithmEvaluator evaluator(m_Program, m_Variables, &budget);
+            Tracer tracer(evaluator, m_Name, budget, range, minDepth, maxDepth);
+
+            if(!evaluator.IsValid() || !tracer.IsValid())
+                return;
+
+            try
+            {
+                for(qint64 row = band; row < roots; row += bands)
+                {
+                    const qint64 iy = row * size;
+
+                    double f00 = tracer.F(0, iy);
+                    double f01 = tracer.F(0, iy + size);
+
+                    for(qint64 column = 0; column < roots; column++)
+                    {
+                        const qint64 ix = column * size;
+                        const double f10 = tracer.F(ix + size, iy);
+                        const double f11 = tracer.F(ix + size, iy + size);
+
+                        tracer.Visit(ix, iy, size, minDepth, f00, f10, f11, f01);
+
+                        f00 = f10;
+                        f01 = f11;
+                    }
+                }
+            }
+            catch(const std::runtime_error &)
+            {
+                // Keep what was traced within the budget
+            }
+
+            QMutexLocker locker(&mutex);
+            lines += tracer.m_Lines;
+        }));
+    }
+
+    pool.waitForDone();
+
+    return Chain(lines, std::min(range.width(), range.height()) * std::ldexp(1.0, -maxDepth) * 1e-3);
+}
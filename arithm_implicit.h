@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+#include "arithm_evaluator.h"
+
+// Implicit curves F(x, y) = 0, traced on an adaptively refined quadtree
+class ArithmImplicit
+{
+public:
+    ArithmImplicit(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                   const std::string &name);
+
+    void SetBudget(const ArithmBudget *budget);
+
+    // Uniform subdivision down to minDepth, adaptive below, polylines separated by NaN points
+    QVector<QPointF> Trace(const QRectF &range, int minDepth, int maxDepth) const;
+
+private:
+    exprtk::token_program m_Program;
+    std::vector<std::string> m_Variables;
+    std::string m_Name;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -0,0 +1,201 @@
+#include "arithm_library.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <cstring>
+
+namespace
+{
+    const quint32 LIBRARY_MAGIC = 0x42494C41; // "ALIB"
+    const quint32 LIBRARY_VERSION = 1;
+
+    // Entries start on a word boundary so programs stay aligned in the map
+    qint64 Padding(qint64 size)
+    {
+        return (4 - (size % 4)) % 4;
+    }
+
+    bool Map(QFile &file, const uchar *&data, qint64 &size)
+    {
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+
+        size = file.size();
+        data = size > 0 ? file.map(0, size) : nullptr;
+
+        return data != nullptr;
+    }
+}
+
+bool ArithmLibrary::Read(const QString &fileName, exprtk::token_program &program)
+{
+    QFile file(fileName);
+
+    const uchar *data;
+    qint64 size;
+
+    if(!Map(file, data, size))
+        return false;
+
+    return program.read(reinterpret_cast<const char*>(data), static_cast<std::size_t>(size));
+}
+
+bool ArithmLibrary::Write(const QString &fileName, const exprtk::token_program &program)
+{
+    std::string buffer;
+    program.write(buffer);
+
+    QSaveFile file(fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(buffer.data(), static_cast<qint64>(buffer.size()));
+
+    return file.commit();
+}
+
+bool ArithmLibrary::Load(const QString &fileName)
+{
+    Clear();
+
+    m_File.setFileName(fileName);
+
+    const uchar *data;
+    qint64 size;
+
+    if(!Map(m_File, data, size))
+        return false;
+
+    quint32 header[3];
+
+    if(size < static_cast<qint64>(sizeof(header)))
+        return false;
+
+    std::memcpy(header, data, sizeof(header));
+
+    if(header[0] != LIBRARY_MAGIC || header[1] != LIBRARY_VERSION)
+        return false;
+
+    m_Entries.reserve(header[2]);
+
+    qint64 offset = sizeof(header);
+    quint32 indexed = 0;
+
+    // Only the expressions are read here, the map stays open for Find
+    for(quint32 i = 0; i < header[2]; i++)
+    {
+        quint32 length;
+
+        if(size - offset < static_cast<qint64>(sizeof(length)))
+            break;
+
+        std::memcpy(&length, data + offset, sizeof(length));
+        offset += sizeof(length);
+
+        if(size - offset < length)
+            break;
+
+        Entry entry;
+        entry.data = reinterpret_cast<const char*>(data + offset);
+        entry.length = length;
+
+        std::string expression;
+
+        if(exprtk::token_program::read_expression(entry.data, length, expression))
+        {
+            Insert(QString::fromStdString(expression), entry);
+            indexed++;
+        }
+
+        offset += length + Padding(length);
+    }
+
+    // Duplicate expressions keep the last program, like Add
+    return indexed == header[2];
+}
+
+bool ArithmLibrary::Save(const QString &fileName) const
+{
+    QSaveFile file(fileName);
+
+    if(!file.open(QIODevice::WriteOnly))
+        return false;
+
+    const quint32 header[3] = { LIBRARY_MAGIC, LIBRARY_VERSION, static_cast<quint32>(m_Entries.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::string buffer;
+    const char padding[4] = { 0, 0, 0, 0 };
+
+    for(const Entry &entry : m_Entries)
+    {
+        // Programs not decoded yet are copied as they are
+        if(entry.data)
+            buffer.assign(entry.data, entry.length);
+        else
+            entry.program.write(buffer);
+
+        const quint32 length = static_cast<quint32>(buffer.size());
+
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(buffer.data(), length);
+        file.write(padding, Padding(length));
+    }
+
+    return file.commit();
+}
+
+void ArithmLibrary::Add(const exprtk::token_program &program)
+{
+    Entry entry;
+    entry.program = program;
+
+    Insert(QString::fromStdString(program.expression()), entry);
+}
+
+void ArithmLibrary::Insert(const QString &expression, const Entry &entry)
+{
+    auto it = m_Index.constFind(expression);
+
+    if(it != m_Index.constEnd())
+    {
+        m_Entries[*it] = entry;
+        return;
+    }
+
+    m_Index.insert(expression, static_cast<int>(m_Entries.size()));
+    m_Entries.push_back(entry);
+}
+
+void ArithmLibrary::Clear()
+{
+    m_Entries.clear();
+    m_Index.clear();
+
+    // Closing unmaps the library
+    m_File.close();
+}
+
+int ArithmLibrary::Count() const
+{
+    return static_cast<int>(m_Entries.size());
+}
+
+const exprtk::token_program *ArithmLibrary::Find(const QString &expression) const
+{
+    auto it = m_Index.constFind(expression);
+
+    if(it == m_Index.constEnd())
+        return nullptr;
+
+    Entry &entry = m_Entries[*it];
+
+    if(entry.data)
+    {
+        entry.isValid = entry.program.read(entry.data, entry.length);
+        entry.data = nullptr;
+    }
+
+    return entry.isValid ? &entry.program : nullptr;
+}
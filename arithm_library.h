@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <vector>
+
+#include "exprtk.hpp"
+
+// Pre-built token programs, stored in a single file and read through a memory map
+class ArithmLibrary
+{
+public:
+    // Single program files
+    static bool Read(const QString &fileName, exprtk::token_program &program);
+    static bool Write(const QString &fileName, const exprtk::token_program &program);
+
+    bool Load(const QString &fileName);
+    bool Save(const QString &fileName) const;
+
+    void Add(const exprtk::token_program &program);
+    void Clear();
+
+    int Count() const;
+
+    // Programs loaded from a library are decoded on first use
+    const exprtk::token_program *Find(const QString &expression) const;
+
+private:
+    struct Entry
+    {
+        // Encoded program in the map, null once decoded or if added
+        const char *data = nullptr;
+        quint32 length = 0;
+
+        exprtk::token_program program;
+        bool isValid = true;
+    };
+
+    void Insert(const QString &expression, const Entry &entry);
+
+    QFile m_File;
+    mutable std::vector<Entry> m_Entries;
+    QHash<QString, int> m_Index;
+};
@@ -0,0 +1,501 @@
+#include "arithm_optimizer.h"
+#include "arithm_task.h"
+
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    // Uniform samples of argmin before the golden-section search
+    const int SCAN_SAMPLES = 32;
+    const int GOLDEN_ITERATIONS = 80;
+
+    // Nelder-Mead iterations per variable and relative tolerance
+    const int SIMPLEX_ITERATIONS = 400;
+    const double SIMPLEX_TOLERANCE = 1e-12;
+
+    const int MAX_STARTS = 64;
+    const std::size_t MAX_OBJECTIVES = 32;
+
+    typedef exprtk::igeneric_function<arithm_double> igfun_t;
+    typedef igfun_t::parameter_list_t parameter_list_t;
+    typedef igfun_t::generic_type generic_type;
+    typedef generic_type::scalar_view scalar_t;
+    typedef generic_type::vector_view vector_t;
+    typedef generic_type::string_view string_t;
+
+    std::vector<std::string> SplitNames(const std::string &names)
+    {
+        std::string normalized = names;
+        std::replace(normalized.begin(), normalized.end(), ',', ' ');
+
+        std::vector<std::string> result;
+        std::istringstream stream(normalized);
+
+        std::string name;
+        while(stream >> name)
+            result.push_back(name);
+
+        return result;
+    }
+}
+
+// Sub-expression with private storage for the optimised variables, which
+// shadow same-named variables of the outer symbol table
+class ArithmOptimizer::Objective
+{
+public:
+    Objective(const std::string &expression, const std::vector<std::string> &names,
+              exprtk::symbol_table<arithm_double> &outer, exprtk::parser<arithm_double> &parser)
+        : m_Values(names.size(), 0)
+    {
+        for(std::size_t i = 0; i < names.size(); i++)
+            m_Locals.add_variable(names[i], m_Values[i]);
+
+        m_Expression.register_symbol_table(m_Locals);
+        m_Expression.register_symbol_table(outer);
+
+        m_isValid = parser.compile(expression, m_Expression);
+    }
+
+    bool IsValid() const
+    {
+        return m_isValid;
+    }
+
+    std::size_t Size() const
+    {
+        return m_Values.size();
+    }
+
+    // NaN counts as worse than any number
+    double operator()(const std::vector<double> &at)
+    {
+        for(std::size_t i = 0; i < m_Values.size(); i++)
+            m_Values[i] = at[i];
+
+        const double value = double(m_Expression.value());
+        return std::isnan(value) ? std::numeric_limits<double>::infinity() : value;
+    }
+
+private:
+    std::vector<arithm_double> m_Values;
+
+    exprtk::symbol_table<arithm_double> m_Locals;
+    exprtk::expression<arithm_double> m_Expression;
+
+    bool m_isValid = false;
+};
+
+// Compiled objectives of one symbol table, the parser is only built when needed
+class ArithmOptimizer::Context
+{
+public:
+    Context(exprtk::symbol_table<arithm_double> &symbols, ArithmBudget *budget)
+        : m_Symbols(symbols), m_Budget(budget)
+    {
+    }
+
+    Objective *Find(const std::string &expression, const std::vector<std::string> &names)
+    {
+        std::string key = expression;
+        for(const std::string &name : names)
+            key += '\n' + name;
+
+        auto it = m_Objectives.find(key);
+        if(it != m_Objectives.end())
+            return it->second->IsValid() ? it->second.get() : nullptr;
+
+        if(m_Objectives.size() >= MAX_OBJECTIVES)
+            m_Objectives.clear();
+
+        std::unique_ptr<Objective> &objective = m_Objectives[key];
+        objective.reset(new Objective(expression, names, m_Symbols, Parser()));
+
+        return objective->IsValid() ? objective.get() : nullptr;
+    }
+
+    // Each start compiles a private copy against a snapshot of the outer
+    // variables, as expressions cannot be evaluated concurrently
+    std::unique_ptr<Objective> Copy(const std::string &expression, const std::vector<std::string> &names,
+                                    exprtk::symbol_table<arithm_double> &snapshot)
+    {
+        exprtk::parser<arithm_double> parser;
+        if(m_Budget)
+            parser.register_loop_runtime_check(*m_Budget);
+
+        std::unique_ptr<Objective> objective(new Objective(expression, names, snapshot, parser));
+        if(!objective->IsValid())
+            objective.reset();
+
+        return objective;
+    }
+
+    exprtk::symbol_table<arithm_double> &Symbols()
+    {
+        return m_Symbols;
+    }
+
+    void Checkpoint()
+    {
+        if(m_Budget)
+            m_Budget->checkpoint();
+    }
+
+private:
+    exprtk::parser<arithm_double> &Parser()
+    {
+        if(!m_Parser)
+        {
+            m_Parser.reset(new exprtk::parser<arithm_double>());
+            if(m_Budget)
+                m_Parser->register_loop_runtime_check(*m_Budget);
+        }
+
+        return *m_Parser;
+    }
+
+private:
+    exprtk::symbol_table<arithm_double> &m_Symbols;
+    ArithmBudget *m_Budget;
+
+    std::unique_ptr<exprtk::parser<arithm_double>> m_Parser;
+    std::map<std::string, std::unique_ptr<Objective>> m_Objectives;
+};
+
+// argmin('expr', 'var', lo, hi), argmax(...)
+class ArithmOptimizer::ArgMin : public igfun_t
+{
+public:
+    using igfun_t::operator();
+
+    ArgMin(Context &context, double sign)
+        : igfun_t("SSTT"), m_Context(context), m_Sign(sign)
+    {
+    }
+
+    arithm_double operator()(parameter_list_t parameters) override
+    {
+        const std::string expression = exprtk::to_str(string_t(parameters[0]));
+        const std::vector<std::string> names = SplitNames(exprtk::to_str(string_t(parameters[1])));
+
+        double lo = double(scalar_t(parameters[2])());
+        double hi = double(scalar_t(parameters[3])());
+
+        if(names.size() != 1 || !std::isfinite(lo) || !std::isfinite(hi) || lo > hi)
+            return std::numeric_limits<arithm_double>::quiet_NaN();
+
+        Objective *objective = m_Context.Find(expression, names);
+        if(!objective)
+            return std::numeric_limits<arithm_double>::quiet_NaN();
+
+        std::vector<double> at(1);
+        auto f = [&](double x)
+        {
+            m_Context.Checkpoint();
+
+            at[0] = x;
+            return m_Sign * (*objective)(at);
+        };
+
+        // Coarse scan picks the basin, so that the search does not stop at a local minimum
+        int best = 0;
+        double bestValue = std::numeric_limits<double>::infinity();
+
+        for(int i = 0; i <= SCAN_SAMPLES; i++)
+        {
+            const double value = f(lo + i * (hi - lo) / SCAN_SAMPLES);
+            if(value < bestValue)
+            {
+                best = i;
+                bestValue = value;
+            }
+        }
+
+        double a = lo + std::max(0, best - 1) * (hi - lo) / SCAN_SAMPLES;
+        double b = lo + std::min(SCAN_SAMPLES, best + 1) * (hi - lo) / SCAN_SAMPLES;
+
+        const double ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+        double c = b - ratio * (b - a), d = a + ratio * (b - a);
+        double fc = f(c), fd = f(d);
+
+        for(int i = 0; i < GOLDEN_ITERATIONS && b - a > 4.0 * std::numeric_limits<double>::epsilon() * std::abs(c); i++)
+        {
+            if(fc < fd)
+            {
+                b = d; d = c; fd = fc;
+                c = b - ratio * (b - a);
+                fc = f(c);
+            }
+            else
+            {
+                a = c; c = d; fc = fd;
+                d = a + ratio * (b - a);
+                fd = f(d);
+            }
+        }
+
+        // The scan may have hit the minimum at an end point exactly
+        const double inner = 0.5 * (a + b);
+        return f(inner) <= bestValue ? inner : lo + best * (hi - lo) / SCAN_SAMPLES;
+    }
+
+private:
+    Context &m_Context;
+    double m_Sign;
+};
+
+// minimize('expr', 'a, b, ...', v [, starts]), maximize(...)
+class ArithmOptimizer::Minimize : public igfun_t
+{
+public:
+    using igfun_t::operator();
+
+    Minimize(Context &context, double sign)
+        : igfun_t("SSV|SSVT"), m_Context(context), m_Sign(sign)
+    {
+    }
+
+    arithm_double operator()(const std::size_t &ps_index, parameter_list_t parameters) override
+    {
+        const std::string expression = exprtk::to_str(string_t(parameters[0]));
+        const std::vector<std::string> names = SplitNames(exprtk::to_str(string_t(parameters[1])));
+
+        vector_t v(parameters[2]);
+
+        std::size_t starts = 1;
+        if(ps_index == 1 && !scalar_t(parameters[3]).to_uint(starts))
+            return std::numeric_limits<arithm_double>::quiet_NaN();
+
+        starts = std::max<std::size_t>(1, std::min<std::size_t>(starts, MAX_STARTS));
+
+        if(names.empty() || names.size() != v.size())
+            return std::numeric_limits<arithm_double>::quiet_NaN();
+
+        std::vector<double> start(v.size());
+        for(std::size_t i = 0; i < v.size(); i++)
+            start[i] = double(v[i]);
+
+        std::vector<double> best = start;
+        double bestValue = std::numeric_limits<double>::infinity();
+
+        if(starts == 1)
+        {
+            Objective *objective = m_Context.Find(expression, names);
+            if(!objective)
+                return std::numeric_limits<arithm_double>::quiet_NaN();
+
+            bestValue = Simplex(*objective, best);
+        }
+        else if(!MultiStart(expression, names, start, starts, best, bestValue))
+            return std::numeric_limits<arithm_double>::quiet_NaN();
+
+        for(std::size_t i = 0; i < v.size(); i++)
+            v[i] = best[i];
+
+        return std::isfinite(bestValue) ? arithm_double(m_Sign * bestValue) : std::numeric_limits<arithm_double>::quiet_NaN();
+    }
+
+private:
+    // Nelder-Mead, returns the minimum of sign * objective and leaves its location in x
+    double Simplex(Objective &objective, std::vector<double> &x)
+    {
+        const std::size_t n = x.size();
+
+        auto f = [&](const std::vector<double> &at)
+        {
+            m_Context.Checkpoint();
+            return m_Sign * objective(at);
+        };
+
+        // Initial simplex of 5 % steps, as fminsearch does
+        std::vector<std::vector<double>> points(n + 1, x);
+        std::vector<double> values(n + 1);
+
+        for(std::size_t i = 0; i < n; i++)
+            points[i + 1][i] = x[i] != 0 ? 1.05 * x[i] : 0.00025;
+
+        for(std::size_t i = 0; i <= n; i++)
+            values[i] = f(points[i]);
+
+        std::vector<std::size_t> order(n + 1);
+        std::vector<double> centroid(n), trial(n), second(n);
+
+        auto blend = [&](std::vector<double> &out, double t)
+        {
+            // centroid + t * (centroid - worst)
+            for(std::size_t j = 0; j < n; j++)
+                out[j] = centroid[j] + t * (centroid[j] - points[order[n]][j]);
+        };
+
+        for(std::size_t iteration = 0; iteration < SIMPLEX_ITERATIONS * n; iteration++)
+        {
+            for(std::size_t i = 0; i <= n; i++)
+                order[i] = i;
+
+            std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return values[a] < values[b]; });
+
+            const double low = values[order[0]], high = values[order[n]];
+            if(std::isfinite(high) && std::abs(high - low) <= SIMPLEX_TOLERANCE * (std::abs(low) + std::abs(high)) + 1e-300)
+                break;
+
+            std::fill(centroid.begin(), centroid.end(), 0.0);
+            for(std::size_t i = 0; i < n; i++)
+            {
+                for(std::size_t j = 0; j < n; j++)
+                    centroid[j] += points[order[i]][j] / n;
+            }
+
+            blend(trial, 1.0);
+            const double reflected = f(trial);
+
+            if(reflected < low)
+            {
+                blend(second, 2.0);
+                const double expanded = f(second);
+
+                if(expanded < reflected)
+                {
+                    points[order[n]] = second;
+                    values[order[n]] = expanded;
+                }
+                else
+                {
+                    points[order[n]] = trial;
+                    values[order[n]] = reflected;
+                }
+            }
+            else if(reflected < values[order[n - 1]])
+            {
+                points[order[n]] = trial;
+                values[order[n]] = reflected;
+            }
+            else
+            {
+                // Contract towards the better of the worst point and its reflection
+                blend(second, reflected < high ? 0.5 : -0.5);
+                const double contracted = f(second);
+
+                if(contracted < std::min(reflected, high))
+                {
+                    points[order[n]] = second;
+                    values[order[n]] = contracted;
+                }
+                else
+                {
+                    // Shrink towards the best point
+                    for(std::size_t i = 1; i <= n; i++)
+                    {
+                        for(std::size_t j = 0; j < n; j++)
+                            points[order[i]][j] = points[order[0]][j] + 0.5 * (points[order[i]][j] - points[order[0]][j]);
+
+                        values[order[i]] = f(points[order[i]]);
+                    }
+                }
+            }
+        }
+
+        const std::size_t best = std::min_element(values.begin(), values.end()) - values.begin();
+        x = points[best];
+
+        return values[best];
+    }
+
+    // Independent Nelder-Mead runs from perturbed starts, one thread per start
+    bool MultiStart(const std::string &expression, const std::vector<std::string> &names,
+                    const std::vector<double> &start, std::size_t starts,
+                    std::vector<double> &best, double &bestValue)
+    {
+        // Outer variables as they are now, optimised names are shadowed anyway
+        std::vector<std::string> outerNames;
+        m_Context.Symbols().get_variable_list(outerNames);
+
+        std::vector<arithm_double> outerValues(outerNames.size());
+        for(std::size_t i = 0; i < outerNames.size(); i++)
+            outerValues[i] = m_Context.Symbols().get_variable(outerNames[i])->value();
+
+        std::vector<std::vector<double>> results(starts, start);
+        std::vector<double> values(starts, std::numeric_limits<double>::infinity());
+        std::vector<char> failed(starts, false);
+
+        QThreadPool pool;
+        for(std::size_t s = 0; s < starts; s++)
+        {
+            pool.start(new ArithmTask([&, s]()
+            {
+                std::vector<arithm_double> storage = outerValues;
+
+                exprtk::symbol_table<arithm_double> snapshot;
+                for(std::size_t i = 0; i < outerNames.size(); i++)
+                    snapshot.add_variable(outerNames[i], storage[i]);
+                snapshot.add_constants();
+
+                std::unique_ptr<Objective> objective = m_Context.Copy(expression, names, snapshot);
+                if(!objective)
+                {
+                    failed[s] = true;
+                    return;
+                }
+
+                // The first start is the given point, the others scatter around it
+                std::mt19937 random(static_cast<unsigned>(s));
+                std::uniform_real_distribution<double> scatter(-1.0, 1.0);
+
+                std::vector<double> &x = results[s];
+                for(std::size_t i = 0; s > 0 && i < x.size(); i++)
+                    x[i] += scatter(random) * std::max(1.0, std::abs(x[i]));
+
+                try
+                {
+                    values[s] = Simplex(*objective, x);
+                }
+                catch(const std::runtime_error &)
+                {
+                    // Budget exhausted, this start keeps what it reached
+                }
+            }));
+        }
+
+        pool.waitForDone();
+
+        if(failed[0])
+            return false;
+
+        // Rethrows on the evaluating thread if the budget ran out meanwhile
+        m_Context.Checkpoint();
+
+        for(std::size_t s = 0; s < starts; s++)
+        {
+            if(values[s] < bestValue)
+            {
+                bestValue = values[s];
+                best = results[s];
+            }
+        }
+
+        return true;
+    }
+
+private:
+    Context &m_Context;
+    double m_Sign;
+};
+
+ArithmOptimizer::ArithmOptimizer(exprtk::symbol_table<arithm_double> &symbols, ArithmBudget *budget)
+    : m_Context(new Context(symbols, budget)),
+      m_ArgMin(new ArgMin(*m_Context, 1.0)), m_ArgMax(new ArgMin(*m_Context, -1.0)),
+      m_Minimize(new Minimize(*m_Context, 1.0)), m_Maximize(new Minimize(*m_Context, -1.0))
+{
+    symbols.add_function("argmin", *m_ArgMin);
+    symbols.add_function("argmax", *m_ArgMax);
+    symbols.add_function("minimize", *m_Minimize);
+    symbols.add_function("maximize", *m_Maximize);
+}
+
+ArithmOptimizer::~ArithmOptimizer()
+{
+}
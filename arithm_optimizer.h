@@ -0,0 +1,36 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arithm_budget.h"
+#include "arithm_evaluator.h"
+
+// Optimisation functions for expressions, the objective is passed as a string
+// and compiled once per call site:
+//   argmin('expr', 'var', lo, hi)            location of the minimum on [lo, hi]
+//   minimize('expr', 'a, b', v [, starts])   Nelder-Mead from v, returns the minimum
+//                                            and leaves its location in v
+// argmax and maximize work the same way.
+class ArithmOptimizer
+{
+public:
+    ArithmOptimizer(exprtk::symbol_table<arithm_double> &symbols, ArithmBudget *budget = nullptr);
+    ~ArithmOptimizer();
+
+    ArithmOptimizer(const ArithmOptimizer &) = delete;
+    ArithmOptimizer &operator=(const ArithmOptimizer &) = delete;
+
+private:
+    class Objective;
+    class Context;
+    class ArgMin;
+    class Minimize;
+
+    std::unique_ptr<Context> m_Context;
+
+    std::unique_ptr<ArgMin> m_ArgMin, m_ArgMax;
+    std::unique_ptr<Minimize> m_Minimize, m_Maximize;
+};
@@ -0,0 +1,393 @@
+#include "arithm_plot.h"
+
+#include <QPainter>
+#include <QPaintEvent>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const int MARGIN_LEFT = 60;
+    const int MARGIN_RIGHT = 20;
+    const int MARGIN_TOP = 20;
+    const int MARGIN_BOTTOM = 40;
+
+    const int MAX_TICKS = 12;
+    const double MARKER_RADIUS = 4.0;
+
+    const QColor CURVE_COLORS[] = { QColor(32, 159, 223), QColor(153, 202, 83), QColor(246, 166, 37),
+                                    QColor(109, 95, 213), QColor(191, 89, 62) };
+
+    QColor CurveColor(int index)
+    {
+        const int count = sizeof(CURVE_COLORS) / sizeof(CURVE_COLORS[0]);
+        return CURVE_COLORS[index % count];
+    }
+
+    // Ticks on multiples of the rounding factor, thinned out to stay readable
+    double TickStep(double delta)
+    {
+        if(!std::isfinite(delta) || delta <= 0)
+            return 0;
+
+        double step = PlotRoundingFactor(delta);
+
+        while(delta / step > MAX_TICKS)
+            step *= (delta / (step * 2) > MAX_TICKS) ? 5 : 2;
+
+        return step;
+    }
+
+    // Gap markers carry a NaN and are equal when placed at the same x
+    bool IsSameSample(const QPointF &a, const QPointF &b)
+    {
+        return a == b || (a.x() == b.x() && std::isnan(a.y()) && std::isnan(b.y()));
+    }
+}
+
+double PlotRoundingFactor(double delta)
+{
+    // "The manufactured rounding table"
+    double factor = 1.0;
+
+    if(delta < 0.00005) factor = 0.000001; // 1µ
+    if(delta >= 0.00005 && delta < 0.0005) factor = 0.00001;
+    if(delta >= 0.0005 && delta < 0.005) factor = 0.0001;
+    if(delta >= 0.005 && delta < 0.05) factor = 0.001;
+    if(delta >= 0.05 && delta < 0.5) factor = 0.01;
+    if(delta >= 0.5 && delta < 5.0) factor = 0.1;
+    if(delta >= 5.0 && delta < 50.0) factor = 1.0;
+    if(delta >= 50.0 && delta < 500.0) factor = 10.0;
+    if(delta >= 500.0 && delta < 5000.0) factor = 100.0;
+    if(delta >= 5000.0 && delta < 50000.0) factor = 1000.0;
+    if(delta >= 50000.0 && delta < 500000.0) factor = 10000.0;
+    if(delta >= 500000.0 && delta < 5000000.0) factor = 100000.0;
+    if(delta >= 5000000.0) factor = 1000000.0; // 1M
+
+    return factor;
+}
+
+ArithmPlot::ArithmPlot(QWidget *parent)
+    : QWidget(parent), m_View(0.0, 0.0, 1.0, 1.0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setFocusPolicy(Qt::NoFocus);
+}
+
+void ArithmPlot::SetView(double xMin, double xMax, double yMin, double yMax)
+{
+    const QRectF view(xMin, yMin, xMax - xMin, yMax - yMin);
+
+    if(view == m_View)
+        return;
+
+    const QRect area = PlotArea();
+
+    // A horizontal pan keeps the scale, so the pixels on screen stay valid up to a shift
+    const bool isPan = view.top() == m_View.top() && view.height() == m_View.height() &&
+                       std::abs(view.width() - m_View.width()) <= m_View.width() * 1e-12;
+    const double shift = (m_View.left() - view.left()) / m_View.width() * area.width() + m_ScrollRemainder;
+
+    m_View = view;
+
+    for(Curve &curve : m_Curves)
+        curve.isDirty = true;
+
+    if(!isPan || !m_Field.isNull() || !std::isfinite(shift) || std::abs(shift) >= area.width() - 2)
+    {
+        m_ScrollRemainder = 0;
+        update();
+        return;
+    }
+
+    // Scroll inside the frame and repaint the exposed strip, the tick labels and the legend only,
+    // the sub-pixel rest is carried over so the content does not drift
+    const int dx = qRound(shift);
+    m_ScrollRemainder = shift - dx;
+
+    scroll(dx, 0, area.adjusted(1, 1, -1, -1));
+    update(QRect(0, area.bottom(), width(), height() - area.bottom()));
+
+    if(m_isLegend)
+        update(LegendArea());
+}
+
+void ArithmPlot::SetCurve(int index, const QString &name, const QVector<QPointF> &points)
+{
+    if(index >= m_Curves.size())
+        SetCurveCount(index + 1);
+
+    Curve &curve = m_Curves[index];
+
+    // Samples shared at the start and the end are already on screen, only the
+    // segments in between, old and new, need a repaint
+    const int common = std::min(curve.points.size(), points.size());
+
+    int prefix = 0;
+    while(prefix < common && IsSameSample(curve.points[prefix], points[prefix]))
+        prefix++;
+
+    int suffix = 0;
+    while(suffix < common - prefix && IsSameSample(curve.points[curve.points.size() - 1 - suffix], points[points.size() - 1 - suffix]))
+        suffix++;
+
+    if(prefix == curve.points.size() && prefix == points.size() && name == curve.name)
+        return;
+
+    QRectF dirty = Bounds(curve.points, prefix - 1, curve.points.size() - suffix + 1);
+    dirty = dirty.united(Bounds(points, prefix - 1, points.size() - suffix + 1));
+
+    const bool isRenamed = name != curve.name;
+    const bool isShown = !curve.points.isEmpty();
+
+    curve.name = name;
+    curve.points = points;
+    curve.isDirty = true;
+
+    update(dirty.toAlignedRect().adjusted(-2, -2, 2, 2).intersected(PlotArea()));
+
+    if(m_isLegend && (isRenamed || isShown != !points.isEmpty()))
+        update(LegendArea());
+}
+
+void ArithmPlot::SetCurveCount(int count)
+{
+    if(count == m_Curves.size())
+        return;
+
+    m_Curves.resize(count);
+    update();
+}
+
+void ArithmPlot::SetLegendVisible(bool visible)
+{
+    if(visible == m_isLegend)
+        return;
+
+    m_isLegend = visible;
+    update();
+}
+
+void ArithmPlot::SetField(const QImage &image, const QRectF &extent, const QVector<QLineF> &contours)
+{
+    if(image.isNull() && m_Field.isNull())
+        return;
+
+    m_Field = image;
+    m_FieldExtent = extent;
+    m_Contours = contours;
+
+    update(PlotArea());
+}
+
+void ArithmPlot::SetMarkers(const QVector<QPointF> &markers)
+{
+    if(markers == m_Markers)
+        return;
+
+    m_Markers = markers;
+    update(PlotArea());
+}
+
+QRectF ArithmPlot::View() const
+{
+    return m_View;
+}
+
+void ArithmPlot::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    for(Curve &curve : m_Curves)
+        curve.isDirty = true;
+}
+
+QRect ArithmPlot::PlotArea() const
+{
+    return rect().adjusted(MARGIN_LEFT, MARGIN_TOP, -MARGIN_RIGHT, -MARGIN_BOTTOM);
+}
+
+QRect ArithmPlot::LegendArea() const
+{
+    const QRect area = PlotArea();
+
+    return QRect(area.left(), area.top(), area.width(), fontMetrics().height() * (m_Curves.size() + 1));
+}
+
+QRectF ArithmPlot::Bounds(const QVector<QPointF> &points, int first, int last) const
+{
+    QPointF topLeft(qInf(), qInf());
+    QPointF bottomRight(-qInf(), -qInf());
+
+    for(int i = std::max(first, 0); i < std::min(last, points.size()); i++)
+    {
+        if(!std::isfinite(points[i].x()) || !std::isfinite(points[i].y()))
+            continue;
+
+        const QPointF point = Map(points[i]);
+        topLeft = QPointF(std::min(topLeft.x(), point.x()), std::min(topLeft.y(), point.y()));
+        bottomRight = QPointF(std::max(bottomRight.x(), point.x()), std::max(bottomRight.y(), point.y()));
+    }
+
+    return topLeft.x() <= bottomRight.x() ? QRectF(topLeft, bottomRight) : QRectF();
+}
+
+QPointF ArithmPlot::Map(const QPointF &point) const
+{
+    const QRect area = PlotArea();
+
+    // Keep far off-screen values within a range the rasterizer handles well
+    const double limit = 16.0 * (width() + height());
+
+    return QPointF(qBound(-limit, area.left() + (point.x() - m_View.left()) / m_View.width() * area.width(), limit),
+                   qBound(-limit, area.bottom() - (point.y() - m_View.top()) / m_View.height() * area.height(), limit));
+}
+
+void ArithmPlot::UpdatePolyline(Curve &curve) const
+{
+    if(!curve.isDirty)
+        return;
+
+    curve.polylines.clear();
+
+    QPolygonF polyline;
+    polyline.reserve(curve.points.size());
+
+    for(const QPointF &point : curve.points)
+    {
+        // NaN and infinite samples break the curve into separate polylines
+        if(!std::isfinite(point.x()) || !std::isfinite(point.y()))
+        {
+            if(polyline.size() > 1)
+                curve.polylines.append(polyline);
+
+            polyline.clear();
+            continue;
+        }
+
+        polyline.append(Map(point));
+    }
+
+    if(polyline.size() > 1)
+        curve.polylines.append(polyline);
+
+    curve.isDirty = false;
+}
+
+void ArithmPlot::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().base());
+
+    DrawAxes(painter);
+
+    painter.setClipRect(PlotArea().intersected(event->rect()));
+
+    if(!m_Field.isNull())
+    {
+        // Image rows run from the top of the extent down
+        const QRectF target(Map(QPointF(m_FieldExtent.left(), m_FieldExtent.bottom())),
+                            Map(QPointF(m_FieldExtent.right(), m_FieldExtent.top())));
+        painter.drawImage(target, m_Field);
+
+        painter.setPen(QPen(QColor(255, 255, 255, 160), 1.0));
+        for(const QLineF &line : m_Contours)
+            painter.drawLine(QLineF(Map(line.p1()), Map(line.p2())));
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+
+    for(int i = 0; i < m_Curves.size(); i++)
+    {
+        Curve &curve = m_Curves[i];
+        UpdatePolyline(curve);
+
+        painter.setPen(QPen(CurveColor(i), 2.0));
+        for(const QPolygonF &polyline : curve.polylines)
+            painter.drawPolyline(polyline);
+    }
+
+    painter.setPen(QPen(palette().text().color(), 1.5));
+    painter.setBrush(palette().base());
+    for(const QPointF &marker : m_Markers)
+        painter.drawEllipse(Map(marker), MARKER_RADIUS, MARKER_RADIUS);
+    painter.setBrush(Qt::NoBrush);
+
+    painter.setClipping(false);
+
+    if(m_isLegend)
+        DrawLegend(painter);
+}
+
+void ArithmPlot::DrawAxes(QPainter &painter) const
+{
+    const QRect area = PlotArea();
+
+    painter.setPen(palette().text().color());
+    painter.drawRect(area);
+
+    QPen grid(palette().mid().color(), 0, Qt::DotLine);
+
+    // Horizontal axis
+    const double xStep = TickStep(m_View.width());
+    for(double x = std::ceil(m_View.left() / xStep) * xStep; xStep > 0 && x <= m_View.right() + xStep * 1e-9; x += xStep)
+    {
+        const int px = qRound(Map(QPointF(x, m_View.top())).x());
+
+        painter.setPen(grid);
+        painter.drawLine(px, area.top(), px, area.bottom());
+
+        painter.setPen(palette().text().color());
+        painter.drawText(QRect(px - 40, area.bottom() + 4, 80, fontMetrics().height()),
+                         Qt::AlignHCenter, QString::number(std::abs(x) < xStep * 1e-9 ? 0.0 : x));
+    }
+
+    // Vertical axis
+    const double yStep = TickStep(m_View.height());
+    for(double y = std::ceil(m_View.top() / yStep) * yStep; yStep > 0 && y <= m_View.bottom() + yStep * 1e-9; y += yStep)
+    {
+        const int py = qRound(Map(QPointF(m_View.left(), y)).y());
+
+        painter.setPen(grid);
+        painter.drawLine(area.left(), py, area.right(), py);
+
+        painter.setPen(palette().text().color());
+        painter.drawText(QRect(0, py - fontMetrics().height() / 2, area.left() - 6, fontMetrics().height()),
+                         Qt::AlignRight | Qt::AlignVCenter, QString::number(std::abs(y) < yStep * 1e-9 ? 0.0 : y));
+    }
+
+    painter.setPen(palette().text().color());
+    painter.drawText(QRect(area.left(), height() - fontMetrics().height() - 2, area.width(), fontMetrics().height()),
+                     Qt::AlignHCenter, "x");
+
+    painter.save();
+    painter.translate(fontMetrics().height() / 2, area.center().y());
+    painter.rotate(-90);
+    painter.drawText(QRect(-area.height() / 2, -fontMetrics().height() / 2, area.height(), fontMetrics().height()),
+                     Qt::AlignCenter, m_Field.isNull() ? "function(x)" : "y");
+    painter.restore();
+}
+
+void ArithmPlot::DrawLegend(QPainter &painter) const
+{
+    const QRect area = PlotArea();
+    const int lineHeight = fontMetrics().height();
+
+    int row = 0;
+    for(int i = 0; i < m_Curves.size(); i++)
+    {
+        if(m_Curves[i].name.isEmpty() || m_Curves[i].points.isEmpty())
+            continue;
+
+        const int y = area.top() + lineHeight / 2 + row * lineHeight;
+
+        painter.setPen(QPen(CurveColor(i), 2.0));
+        painter.drawLine(area.left() + 8, y + lineHeight / 2, area.left() + 24, y + lineHeight / 2);
+
+        painter.setPen(palette().text().color());
+        painter.drawText(QRect(area.left() + 30, y, area.width() - 30, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, m_Curves[i].name);
+
+        row++;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QImage>
+#include <QLineF>
+#include <QPolygonF>
+#include <QRectF>
+#include <QVector>
+#include <QWidget>
+
+// Rounding step of the vertical range, also used as axis tick spacing
+double PlotRoundingFactor(double delta);
+
+// Lightweight QPainter plot, an alternative to QChartView for large series
+class ArithmPlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ArithmPlot(QWidget *parent = nullptr);
+
+    void SetView(double xMin, double xMax, double yMin, double yMax);
+    void SetCurve(int index, const QString &name, const QVector<QPointF> &points);
+    void SetCurveCount(int count);
+    void SetLegendVisible(bool visible);
+
+    // Colour-mapped z = f(x, y) image below the curves, extent in data coordinates
+    void SetField(const QImage &image, const QRectF &extent, const QVector<QLineF> &contours);
+
+    // Points of interest (roots, ...) drawn on top of the curves
+    void SetMarkers(const QVector<QPointF> &markers);
+
+    QRectF View() const;
+    QRect PlotArea() const;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Curve
+    {
+        QString name;
+        QVector<QPointF> points;
+
+        // Persistent polylines in widget coordinates, split at gaps and
+        // rebuilt on view changes only
+        QVector<QPolygonF> polylines;
+        bool isDirty = true;
+    };
+
+    QRect LegendArea() const;
+    QRectF Bounds(const QVector<QPointF> &points, int first, int last) const;
+    QPointF Map(const QPointF &point) const;
+    void UpdatePolyline(Curve &curve) const;
+
+    void DrawAxes(QPainter &painter) const;
+    void DrawLegend(QPainter &painter) const;
+
+private:
+    QVector<Curve> m_Curves;
+    QRectF m_View;
+
+    QImage m_Field;
+    QRectF m_FieldExtent;
+    QVector<QLineF> m_Contours;
+
+    QVector<QPointF> m_Markers;
+
+    bool m_isLegend = true;
+
+    // Sub-pixel part of the pan not yet scrolled
+    double m_ScrollRemainder = 0;
+};
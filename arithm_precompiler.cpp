@@ -0,0 +1,90 @@
+#include "arithm_precompiler.h"
+#include "arithm_optimizer.h"
+#include "arithm_task.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+ArithmPrecompiler::ArithmPrecompiler()
+    : m_Cancelled(false)
+{
+    // Leave a core for the user interface
+    m_Pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+ArithmPrecompiler::~ArithmPrecompiler()
+{
+    Cancel();
+}
+
+void ArithmPrecompiler::Start(const QStringList &expressions, const std::vector<std::string> &variables, const ArithmCache &cache)
+{
+    Cancel();
+
+    m_Variables = variables;
+    m_Cache = cache;
+    m_Cancelled = false;
+
+    // Most recent entries first
+    for(const QString &expression : expressions)
+        m_Pool.start(new ArithmTask([this, expression]() { Compile(expression); }, QThread::LowestPriority));
+}
+
+void ArithmPrecompiler::Cancel()
+{
+    m_Cancelled = true;
+    m_Pool.clear();
+    m_Pool.waitForDone();
+}
+
+bool ArithmPrecompiler::Find(const QString &expression, exprtk::token_program &program)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    auto it = m_Programs.constFind(expression);
+    if(it == m_Programs.constEnd())
+        return false;
+
+    program = *it;
+    return true;
+}
+
+void ArithmPrecompiler::Compile(const QString &expression)
+{
+    if(m_Cancelled)
+        return;
+
+    {
+        QMutexLocker locker(&m_Mutex);
+        if(m_Programs.contains(expression))
+            return;
+    }
+
+    exprtk::token_program program;
+
+    if(!m_Cache.Load(expression, program))
+    {
+        // Expressions only bind to the dialog's storage on the GUI thread,
+        // so the worker parses against placeholders of the same names
+        std::vector<arithm_double> storage(m_Variables.size());
+
+        exprtk::symbol_table<arithm_double> symbols;
+        for(std::size_t i = 0; i < m_Variables.size(); i++)
+            symbols.add_variable(m_Variables[i], storage[i]);
+        symbols.add_constants();
+
+        ArithmOptimizer optimizer(symbols);
+
+        exprtk::expression<arithm_double> compiled;
+        compiled.register_symbol_table(symbols);
+
+        exprtk::parser<arithm_double> parser;
+        if(!parser.compile(expression.toStdString(), compiled, program))
+            return;
+
+        m_Cache.Store(program);
+    }
+
+    QMutexLocker locker(&m_Mutex);
+    m_Programs.insert(expression, program);
+}
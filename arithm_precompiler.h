@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include <vector>
+
+#include "exprtk.hpp"
+#include "arithm_cache.h"
+
+// Token programs for recent history entries, built on a low priority thread pool
+class ArithmPrecompiler
+{
+public:
+    ArithmPrecompiler();
+    ~ArithmPrecompiler();
+
+    void Start(const QStringList &expressions, const std::vector<std::string> &variables, const ArithmCache &cache);
+    void Cancel();
+
+    bool Find(const QString &expression, exprtk::token_program &program);
+
+private:
+    void Compile(const QString &expression);
+
+private:
+    QThreadPool m_Pool;
+
+    QMutex m_Mutex;
+    QHash<QString, exprtk::token_program> m_Programs;
+
+    std::vector<std::string> m_Variables;
+    ArithmCache m_Cache;
+
+    std::atomic<bool> m_Cancelled;
+};
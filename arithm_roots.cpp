@@ -0,0 +1,197 @@
+#include "arithm_roots.h"
+#include "arithm_budget.h"
+#include "arithm_task.h"
+#include "settings.h"
+
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace
+{
+    // Brent's method, inverse quadratic interpolation guarded by bisection
+    bool Brent(const std::function<double(double)> &f, double a, double b, double fa, double fb, double &root)
+    {
+        double c = a, fc = fa;
+        double d = b - a, e = d;
+
+        for(int i = 0; i < PLOT_ROOT_ITERATIONS; i++)
+        {
+            if((fb > 0) == (fc > 0))
+            {
+                c = a;
+                fc = fa;
+                d = e = b - a;
+            }
+
+            if(std::abs(fc) < std::abs(fb))
+            {
+                a = b; b = c; c = a;
+                fa = fb; fb = fc; fc = fa;
+            }
+
+            const double tolerance = 2.0 * std::numeric_limits<double>::epsilon() * std::abs(b) + 1e-300;
+            const double m = 0.5 * (c - b);
+
+            if(std::abs(m) <= tolerance || fb == 0)
+            {
+                root = b;
+                return true;
+            }
+
+            if(std::abs(e) >= tolerance && std::abs(fa) > std::abs(fb))
+            {
+                double p, q;
+                const double s = fb / fa;
+
+                if(a == c)
+                {
+                    // Secant step
+                    p = 2.0 * m * s;
+                    q = 1.0 - s;
+                }
+                else
+                {
+                    const double r = fb / fc;
+                    const double t = fa / fc;
+                    p = s * (2.0 * m * t * (t - r) - (b - a) * (r - 1.0));
+                    q = (t - 1.0) * (r - 1.0) * (s - 1.0);
+                }
+
+                if(p > 0)
+                    q = -q;
+                else
+                    p = -p;
+
+                if(2.0 * p < std::min(3.0 * m * q - std::abs(tolerance * q), std::abs(e * q)))
+                {
+                    e = d;
+                    d = p / q;
+                }
+                else
+                {
+                    d = m;
+                    e = m;
+                }
+            }
+            else
+            {
+                d = m;
+                e = m;
+            }
+
+            a = b;
+            fa = fb;
+            b += std::abs(d) > tolerance ? d : (m > 0 ? tolerance : -tolerance);
+            fb = f(b);
+
+            if(!std::isfinite(fb))
+                return false;
+        }
+
+        root = b;
+        return false;
+    }
+}
+
+ArithmRoots::ArithmRoots(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                         const std::vector<std::string> &curves)
+    : m_Program(program), m_Variables(variables), m_Curves(curves)
+{
+}
+
+void ArithmRoots::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+QVector<ArithmRoot> ArithmRoots::Find(const QVector<ArithmRootBracket> &brackets) const
+{
+    QVector<ArithmRoot> roots(brackets.size());
+    QVector<bool> isFound(brackets.size(), false);
+
+    // Every thread takes every n-th bracket on its own expression copy
+    QThreadPool pool;
+    const int tasks = qMin(brackets.size(), qMax(1, QThread::idealThreadCount()));
+
+    // One deadline for all threads, the one of the calling evaluation if already started
+    ArithmBudget budget(m_Budget);
+    budget.resume();
+
+    for(int task = 0; task < tasks; task++)
+    {
+        pool.start(new ArithmTask([&, task, tasks]()
+        {
+            ArithmEvaluator evaluator(m_Program, m_Variables, &budget);
+            arithm_double *x = evaluator.Variable("x");
+
+            if(!evaluator.IsValid() || !x)
+                return;
+
+            std::vector<arithm_double*> curves;
+            for(const std::string &name : m_Curves)
+                curves.push_back(name.empty() ? nullptr : evaluator.Variable(name));
+
+            for(int i = task; i < brackets.size(); i += tasks)
+            {
+                const ArithmRootBracket &bracket = brackets[i];
+
+                // Value of the curve, or of the difference of both curves
+                auto value = [&](double at, double *y) -> double
+                {
+                    budget.checkpoint();
+
+                    *x = at;
+                    const arithm_double result = evaluator.Value();
+
+                    const int first = bracket.first, second = bracket.second;
+                    const arithm_double a = curves[first] ? *curves[first] : result;
+                    const arithm_double b = second < 0 ? 0 : (curves[second] ? *curves[second] : result);
+
+                    if(y)
+                        *y = double(a);
+
+                    return double(a - b);
+                };
+
+                try
+                {
+                    const double fa = value(bracket.a, nullptr);
+                    const double fb = value(bracket.b, nullptr);
+
+                    double root;
+                    if(!Brent([&](double at) { return value(at, nullptr); }, bracket.a, bracket.b, fa, fb, root))
+                        continue;
+
+                    // A sign change across a pole converges to the pole itself
+                    double y;
+                    const double fr = value(root, &y);
+                    if(!std::isfinite(fr) || std::abs(fr) > std::min(std::abs(fa), std::abs(fb)))
+                        continue;
+
+                    roots[i] = ArithmRoot{ root, y, bracket.first, bracket.second };
+                    isFound[i] = true;
+                }
+                catch(const std::runtime_error &)
+                {
+                    // Budget exhausted, drop the remaining brackets of this thread
+                    break;
+                }
+            }
+        }));
+    }
+
+    pool.waitForDone();
+
+    QVector<ArithmRoot> result;
+    for(int i = 0; i < roots.size(); i++)
+    {
+        if(isFound[i])
+            result.append(roots[i]);
+    }
+
+    return result;
+}
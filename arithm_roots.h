@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QVector>
+
+#include "arithm_evaluator.h"
+
+// Sign change of one curve, or of the difference of two curves, between a and b
+struct ArithmRootBracket
+{
+    double a, b;
+    int first, second;
+};
+
+struct ArithmRoot
+{
+    double x, y;
+    int first, second;
+};
+
+// Brent's method on brackets taken from the sample grid, one expression copy per thread
+class ArithmRoots
+{
+public:
+    // Curve names are read after each evaluation, an empty name stands for the result
+    ArithmRoots(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                const std::vector<std::string> &curves);
+
+    void SetBudget(const ArithmBudget *budget);
+
+    // Roots in bracket order, brackets around poles and unfinished ones are dropped
+    QVector<ArithmRoot> Find(const QVector<ArithmRootBracket> &brackets) const;
+
+private:
+    exprtk::token_program m_Program;
+    std::vector<std::string> m_Variables;
+    std::vector<std::string> m_Curves;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -0,0 +1,142 @@
+#include "arithm_split.h"
+#include "settings.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+bool ArithmSplit::Curve(const QVector<QPointF> &samples, const std::function<double(double)> &evaluate,
+                        QVector<QPointF> &result, QVector<double> *poles)
+{
+    result.clear();
+    result.reserve(samples.size() + 16);
+
+    // Typical step between neighbours, suspects are far above it
+    QVector<double> steps;
+    for(int i = 1; i < samples.size(); i++)
+    {
+        const double step = std::abs(samples[i].y() - samples[i - 1].y());
+        if(std::isfinite(step))
+            steps.append(step);
+    }
+
+    double typical = 0;
+    if(!steps.isEmpty())
+    {
+        std::nth_element(steps.begin(), steps.begin() + steps.size() / 2, steps.end());
+        typical = steps[steps.size() / 2];
+    }
+
+    const double nan = std::nan("1");
+
+    int i = 0;
+    int suspects = 0;
+
+    try
+    {
+        for(; i < samples.size(); i++)
+        {
+            if(i == 0)
+            {
+                result.append(samples[i]);
+                continue;
+            }
+
+            QPointF a = samples[i - 1];
+            QPointF b = samples[i];
+
+            const bool isGap = std::isfinite(a.y()) != std::isfinite(b.y());
+            const double jump = std::abs(b.y() - a.y());
+
+            // Noisy curves would otherwise cost PLOT_BISECTIONS evaluations per sample
+            if((!isGap && !(jump > PLOT_JUMP_FACTOR * typical && jump > 0)) || ++suspects > PLOT_MAX_SUSPECTS)
+            {
+                result.append(b);
+                continue;
+            }
+
+            // Bisect towards the discontinuity, keeping the half with the larger jump
+            for(int k = 0; k < PLOT_BISECTIONS; k++)
+            {
+                const double x = 0.5 * (a.x() + b.x());
+                const QPointF m(x, evaluate(x));
+
+                if(isGap)
+                {
+                    if(std::isfinite(m.y()) == std::isfinite(a.y()))
+                        a = m;
+                    else
+                        b = m;
+                }
+                else if(!std::isfinite(m.y()) || std::abs(m.y() - a.y()) > std::abs(b.y() - m.y()))
+                    b = m;
+                else
+                    a = m;
+            }
+
+            if(isGap)
+            {
+                // Extend the curve up to the edge of its domain, the gap in between
+                const QPointF gap(0.5 * (a.x() + b.x()), nan);
+                if(std::isfinite(a.y()))
+                    result << a << gap;
+                else
+                    result << gap << b;
+
+                result.append(samples[i]);
+                continue;
+            }
+
+            // A continuous steep section shrinks with the interval, a discontinuity does not
+            const double remaining = std::abs(b.y() - a.y());
+            if(std::isfinite(remaining) && remaining < 0.5 * jump)
+            {
+                result.append(samples[i]);
+                continue;
+            }
+
+            const double outer = std::max(std::abs(samples[i - 1].y()), std::abs(samples[i].y()));
+            if(poles && (!std::isfinite(remaining) || std::max(std::abs(a.y()), std::abs(b.y())) > 2.0 * outer))
+                poles->append(0.5 * (a.x() + b.x()));
+
+            result << a << QPointF(0.5 * (a.x() + b.x()), nan) << b << samples[i];
+        }
+    }
+    catch(const std::runtime_error &)
+    {
+        // Budget exhausted, show the remaining samples unsplit
+        for(; i < samples.size(); i++)
+            result.append(samples[i]);
+
+        return false;
+    }
+
+    return true;
+}
+
+std::pair<double, double> ArithmSplit::Range(const QVector<QVector<QPointF>> &curves, const QVector<double> &poles, double width)
+{
+    const double window = width * PLOT_POLE_WINDOW;
+
+    std::pair<double, double> range(std::nan("1"), std::nan("1"));
+    for(const QVector<QPointF> &curve : curves)
+    {
+        for(const QPointF &point : curve)
+        {
+            if(!std::isfinite(point.y()))
+                continue;
+
+            bool isNearPole = false;
+            for(double pole : poles)
+                isNearPole = isNearPole || std::abs(point.x() - pole) < window;
+
+            if(isNearPole)
+                continue;
+
+            range.first = std::isnan(range.first) ? point.y() : std::min(range.first, point.y());
+            range.second = std::isnan(range.second) ? point.y() : std::max(range.second, point.y());
+        }
+    }
+
+    return range;
+}
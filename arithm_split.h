@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QPointF>
+#include <QVector>
+#include <functional>
+#include <utility>
+
+// Splits sampled curves at jumps, poles and the edges of their domain
+class ArithmSplit
+{
+public:
+    // Bisects suspect intervals with the given function, separating the parts by a NaN point
+    // and collecting poles (if given). Returns false if the function threw because its budget
+    // was exhausted, the remaining samples are then left unsplit.
+    static bool Curve(const QVector<QPointF> &samples, const std::function<double(double)> &evaluate,
+                      QVector<QPointF> &result, QVector<double> *poles);
+
+    // Vertical range without the asymptotic parts next to poles, NaN if there are no finite points
+    static std::pair<double, double> Range(const QVector<QVector<QPointF>> &curves, const QVector<double> &poles, double width);
+};
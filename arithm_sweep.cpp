@@ -0,0 +1,174 @@
+#include "arithm_sweep.h"
+#include "arithm_budget.h"
+#include "arithm_split.h"
+#include "arithm_task.h"
+#include "settings.h"
+
+#include <cmath>
+
+uint qHash(const ArithmSweep::FrameKey &key, uint seed)
+{
+    return qHash(key.xMin, seed) ^ qHash(key.xMax, seed) ^ qHash(key.samples, seed) ^ (qHash(key.parameter, seed) << 1);
+}
+
+ArithmSweep::ArithmSweep()
+{
+}
+
+ArithmSweep::~ArithmSweep()
+{
+    m_Pool.waitForDone();
+}
+
+void ArithmSweep::Reset(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                        const std::vector<std::string> &curves, const std::string &parameter)
+{
+    // Frames stay valid while the expression and its curves do
+    if(program.expression() == m_Program.expression() && curves == m_Curves && parameter == m_Parameter)
+        return;
+
+    m_Program = program;
+    m_Variables = variables;
+    m_Curves = curves;
+    m_Parameter = parameter;
+
+    m_Frames.clear();
+    m_Recent.clear();
+}
+
+void ArithmSweep::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+QVector<ArithmSweepFrame> ArithmSweep::Frames(double xMin, double xMax, int samples, const QVector<double> &parameters)
+{
+    QVector<ArithmSweepFrame> frames(parameters.size());
+    QVector<FrameKey> keys(parameters.size());
+    QVector<bool> isComplete(parameters.size(), false);
+    QVector<int> missing;
+
+    for(int i = 0; i < parameters.size(); i++)
+    {
+        keys[i] = FrameKey{ xMin, xMax, samples, parameters[i] };
+        frames[i].parameter = parameters[i];
+
+        auto it = m_Frames.constFind(keys[i]);
+        if(it == m_Frames.constEnd())
+        {
+            missing.append(i);
+            continue;
+        }
+
+        frames[i] = it.value();
+        m_Recent.removeOne(keys[i]);
+        m_Recent.append(keys[i]);
+    }
+
+    // One deadline for the whole family, the one of the calling evaluation if already started
+    ArithmBudget budget(m_Budget);
+    budget.resume();
+
+    // Every thread takes every n-th missing member on its own expression copy
+    const int tasks = qMin(missing.size(), qMax(1, QThread::idealThreadCount()));
+
+    for(int task = 0; task < tasks; task++)
+    {
+        m_Pool.start(new ArithmTask([&, task, tasks]()
+        {
+            ArithmEvaluator evaluator(m_Program, m_Variables, &budget);
+
+            for(int i = task; i < missing.size(); i += tasks)
+            {
+                const int member = missing[i];
+                isComplete[member] = Compute(keys[member], frames[member], evaluator, budget);
+            }
+        }));
+    }
+
+    m_Pool.waitForDone();
+
+    for(int member : missing)
+    {
+        if(!isComplete[member])
+            continue;
+
+        m_Frames.insert(keys[member], frames[member]);
+        m_Recent.append(keys[member]);
+    }
+
+    // Least recently shown members go first
+    while(m_Recent.size() > PLOT_SWEEP_CACHE)
+        m_Frames.remove(m_Recent.takeFirst());
+
+    return frames;
+}
+
+bool ArithmSweep::Compute(const FrameKey &key, ArithmSweepFrame &frame, ArithmEvaluator &evaluator, ArithmBudget &budget) const
+{
+    arithm_double *x = evaluator.Variable("x");
+    arithm_double *parameter = evaluator.Variable(m_Parameter);
+
+    frame.curves.resize(int(m_Curves.size()));
+
+    // Invalid members stay empty, sampling them again would not change that
+    if(!evaluator.IsValid() || !x || !parameter)
+        return true;
+
+    std::vector<arithm_double*> curves;
+    for(const std::string &name : m_Curves)
+        curves.push_back(name.empty() ? nullptr : evaluator.Variable(name));
+
+    for(QVector<QPointF> &curve : frame.curves)
+        curve.reserve(key.samples);
+
+    *parameter = key.parameter;
+
+    bool isComplete = true;
+
+    try
+    {
+        const int last = qMax(1, key.samples - 1);
+        for(int i = 0; i < key.samples; i++)
+        {
+            budget.checkpoint();
+
+            *x = key.xMin + i * (key.xMax - key.xMin) / last;
+            const arithm_double result = evaluator.Value();
+
+            for(std::size_t j = 0; j < curves.size(); j++)
+                frame.curves[int(j)].append(QPointF(double(*x), double(curves[j] ? *curves[j] : result)));
+        }
+    }
+    catch(const std::runtime_error &)
+    {
+        // Show the partial member, but sample it again within the next budget
+        isComplete = false;
+    }
+
+    // Split here, so that scrubbing shows cached members without evaluating anything
+    QVector<double> poles;
+
+    for(std::size_t j = 0; j < curves.size() && isComplete; j++)
+    {
+        auto evaluate = [&](double at) -> double
+        {
+            budget.checkpoint();
+
+            *x = at;
+            const arithm_double result = evaluator.Value();
+
+            return double(curves[j] ? *curves[j] : result);
+        };
+
+        QVector<QPointF> split;
+        isComplete = ArithmSplit::Curve(frame.curves[int(j)], evaluate, split, &poles);
+        frame.curves[int(j)] = split;
+    }
+
+    const std::pair<double, double> range = ArithmSplit::Range(frame.curves, poles, key.xMax - key.xMin);
+    frame.yMin = range.first;
+    frame.yMax = range.second;
+
+    return isComplete;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QThreadPool>
+#include <QVector>
+#include <cmath>
+
+#include "arithm_evaluator.h"
+
+// One member of a curve family, sampled over the x-grid
+struct ArithmSweepFrame
+{
+    double parameter;
+
+    // One series per requested curve, split at jumps and poles
+    QVector<QVector<QPointF>> curves;
+
+    // Vertical range without the parts next to poles, NaN if there are no finite points
+    double yMin = std::nan("1");
+    double yMax = std::nan("1");
+};
+
+// Families of curves over a swept parameter, members sampled in parallel and cached
+class ArithmSweep
+{
+public:
+    ArithmSweep();
+    ~ArithmSweep();
+
+    // Curve names are read after each evaluation, an empty name stands for the result
+    void Reset(const exprtk::token_program &program, const std::vector<std::string> &variables,
+               const std::vector<std::string> &curves, const std::string &parameter);
+    void SetBudget(const ArithmBudget *budget);
+
+    // Computes the members not cached for this grid yet, the others are returned as is.
+    // Members cut off by the budget are shown partially and sampled again next time.
+    QVector<ArithmSweepFrame> Frames(double xMin, double xMax, int samples, const QVector<double> &parameters);
+
+private:
+    struct FrameKey
+    {
+        double xMin, xMax;
+        int samples;
+        double parameter;
+
+        bool operator==(const FrameKey &other) const
+        {
+            return xMin == other.xMin && xMax == other.xMax &&
+                   samples == other.samples && parameter == other.parameter;
+        }
+    };
+
+    friend uint qHash(const FrameKey &key, uint seed);
+
+    // Returns false if the budget ran out before the member was complete
+    bool Compute(const FrameKey &key, ArithmSweepFrame &frame, ArithmEvaluator &evaluator, ArithmBudget &budget) const;
+
+private:
+    QThreadPool m_Pool;
+
+    QHash<FrameKey, ArithmSweepFrame> m_Frames;
+    QList<FrameKey> m_Recent;
+
+    exprtk::token_program m_Program;
+    std::vector<std::string> m_Variables;
+    std::vector<std::string> m_Curves;
+    std::string m_Parameter;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -0,0 +1,14 @@
+#include "arithm_task.h"
+
+ArithmTask::ArithmTask(const std::function<void()> &work, QThread::Priority priority)
+    : m_Work(work), m_Priority(priority)
+{
+}
+
+void ArithmTask::run()
+{
+    if(m_Priority != QThread::InheritPriority)
+        QThread::currentThread()->setPriority(m_Priority);
+
+    m_Work();
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QRunnable>
+#include <QThread>
+#include <functional>
+
+// Thread pool task running a function, optionally at a different priority
+class ArithmTask : public QRunnable
+{
+public:
+    ArithmTask(const std::function<void()> &work, QThread::Priority priority = QThread::InheritPriority);
+
+    void run() override;
+
+private:
+    std::function<void()> m_Work;
+    QThread::Priority m_Priority;
+};
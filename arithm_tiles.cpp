@@ -0,0 +1,221 @@
+#include "arithm_tiles.h"
+#include "arithm_budget.h"
+#include "arithm_split.h"
+#include "arithm_task.h"
+
+#include <QMutexLocker>
+
+namespace
+{
+    const int TILE_CACHE_SIZE = 256;
+}
+
+ArithmTiles::ArithmTiles(QObject *parent)
+    : QObject(parent), m_Generation(0)
+{
+}
+
+ArithmTiles::~ArithmTiles()
+{
+    m_Generation++;
+    m_Pool.clear();
+    m_Pool.waitForDone();
+}
+
+void ArithmTiles::Reset(const exprtk::token_program &program, const std::vector<std::string> &variables,
+                        const std::vector<std::string> &curves, int samples)
+{
+    // Running tasks see the new generation and drop their result
+    m_Pool.clear();
+
+    std::shared_ptr<Config> config = std::make_shared<Config>();
+    config->program = program;
+    config->variables = variables;
+    config->curves = curves;
+    config->samples = qMax(2, samples);
+    config->generation = ++m_Generation;
+
+    QMutexLocker locker(&m_Mutex);
+    m_Config = config;
+    m_Tiles.clear();
+    m_Pending.clear();
+    m_Recent.clear();
+}
+
+void ArithmTiles::SetBudget(const ArithmBudget *budget)
+{
+    m_Budget = budget;
+}
+
+void ArithmTiles::Clear()
+{
+    m_Pool.clear();
+    m_Generation++;
+
+    QMutexLocker locker(&m_Mutex);
+    m_Config.reset();
+    m_Tiles.clear();
+    m_Pending.clear();
+    m_Recent.clear();
+}
+
+quint64 ArithmTiles::Generation() const
+{
+    return m_Generation;
+}
+
+bool ArithmTiles::Find(double width, qint64 index, ArithmTile &tile)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    const TileKey key(width, index);
+
+    auto it = m_Tiles.constFind(key);
+    if(it == m_Tiles.constEnd())
+        return false;
+
+    m_Recent.removeOne(key);
+    m_Recent.append(key);
+
+    tile = *it;
+    return true;
+}
+
+void ArithmTiles::Request(double width, qint64 index)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    const TileKey key(width, index);
+
+    if(!m_Config || m_Tiles.contains(key) || m_Pending.contains(key))
+        return;
+
+    m_Pending.insert(key);
+
+    std::shared_ptr<const Config> config = m_Config;
+    m_Pool.start(new ArithmTask([this, config, key]() { Compute(config, key); }));
+}
+
+void ArithmTiles::Insert(double width, qint64 index, const ArithmTile &tile)
+{
+    QMutexLocker locker(&m_Mutex);
+
+    const TileKey key(width, index);
+
+    if(!m_Config || m_Tiles.contains(key))
+        return;
+
+    // A task still sampling it drops its result for the cached one
+    m_Pending.remove(key);
+    m_Tiles.insert(key, tile);
+    m_Recent.append(key);
+
+    while(m_Recent.size() > TILE_CACHE_SIZE)
+        m_Tiles.remove(m_Recent.takeFirst());
+}
+
+void ArithmTiles::Compute(std::shared_ptr<const Config> config, TileKey key)
+{
+    if(config->generation != m_Generation)
+        return;
+
+    ArithmBudget budget(m_Budget);
+
+    ArithmEvaluator evaluator(config->program, config->variables, &budget);
+    arithm_double *x = evaluator.Variable("x");
+
+    ArithmTile tile;
+    tile.curves.resize(static_cast<int>(config->curves.size()));
+
+    if(evaluator.IsValid() && x)
+    {
+        std::vector<arithm_double*> curves;
+        for(const std::string &name : config->curves)
+            curves.push_back(name.empty() ? nullptr : evaluator.Variable(name));
+
+        const double width = key.first;
+        const double a = key.second * width;
+        const double b = a + width;
+
+        budget.start();
+
+        bool isSampled = true;
+
+        // Up to and including the start of the next tile, so that a jump between
+        // the two is split here, that sample is dropped again below
+        try
+        {
+            for(int i = 0; i <= config->samples; i++)
+            {
+                budget.checkpoint();
+
+                if(config->generation != m_Generation)
+                    return;
+
+                *x = i < config->samples ? a + i * width / config->samples : b;
+
+                const arithm_double result = evaluator.Value();
+
+                for(std::size_t j = 0; j < curves.size(); j++)
+                {
+                    const arithm_double y = curves[j] ? *curves[j] : result;
+                    tile.curves[int(j)].append(QPointF(double(*x), double(y)));
+                }
+            }
+        }
+        catch(const std::runtime_error &)
+        {
+            // Keep the partial tile, so that an exhausted budget is not retried
+            isSampled = false;
+        }
+
+        // Split on this thread, so that panning only joins tiles
+        for(std::size_t j = 0; j < curves.size() && isSampled; j++)
+        {
+            auto evaluate = [&](double at) -> double
+            {
+                budget.checkpoint();
+
+                *x = at;
+                const arithm_double result = evaluator.Value();
+
+                return double(curves[j] ? *curves[j] : result);
+            };
+
+            QVector<QPointF> split;
+            isSampled = ArithmSplit::Curve(tile.curves[int(j)], evaluate, split, nullptr);
+            tile.curves[int(j)] = split;
+        }
+
+        for(QVector<QPointF> &curve : tile.curves)
+        {
+            while(!curve.isEmpty() && curve.last().x() >= b)
+                curve.removeLast();
+        }
+
+        // A cancelled tile has to be computed again on request
+        if(budget.isCancelled())
+        {
+            QMutexLocker locker(&m_Mutex);
+            if(config->generation == m_Generation)
+                m_Pending.remove(key);
+            return;
+        }
+    }
+
+    QMutexLocker locker(&m_Mutex);
+
+    if(config->generation != m_Generation || m_Tiles.contains(key))
+        return;
+
+    m_Pending.remove(key);
+    m_Tiles.insert(key, tile);
+    m_Recent.append(key);
+
+    while(m_Recent.size() > TILE_CACHE_SIZE)
+        m_Tiles.remove(m_Recent.takeFirst());
+
+    locker.unlock();
+
+    QMetaObject::invokeMethod(this, "TileReady", Qt::QueuedConnection, Q_ARG(quint64, config->generation));
+}
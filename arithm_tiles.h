@@ -0,0 +1,76 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointF>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "arithm_evaluator.h"
+
+struct ArithmTile
+{
+    // One series per requested curve
+    QVector<QVector<QPointF>> curves;
+};
+
+// Fixed-width x tiles per zoom level, sampled on demand by a thread pool and split
+// at jumps and poles. A tile covers [a, a + width), so that stitched tiles do not overlap.
+class ArithmTiles : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ArithmTiles(QObject *parent = nullptr);
+    ~ArithmTiles();
+
+    // Curve names are read after each evaluation, an empty name stands for the result
+    void Reset(const exprtk::token_program &program, const std::vector<std::string> &variables,
+               const std::vector<std::string> &curves, int samples);
+    void SetBudget(const ArithmBudget *budget);
+
+    // Drops all tiles and stops sampling until the next Reset
+    void Clear();
+    quint64 Generation() const;
+
+    bool Find(double width, qint64 index, ArithmTile &tile);
+    void Request(double width, qint64 index);
+
+    // Tiles sampled elsewhere, e.g. from the grid of the last evaluation
+    void Insert(double width, qint64 index, const ArithmTile &tile);
+
+signals:
+    void TileReady(quint64 generation);
+
+private:
+    struct Config
+    {
+        exprtk::token_program program;
+        std::vector<std::string> variables;
+        std::vector<std::string> curves;
+        int samples;
+        quint64 generation;
+    };
+
+    typedef QPair<double, qint64> TileKey;
+
+    void Compute(std::shared_ptr<const Config> config, TileKey key);
+
+private:
+    QThreadPool m_Pool;
+
+    QMutex m_Mutex;
+    QHash<TileKey, ArithmTile> m_Tiles;
+    QSet<TileKey> m_Pending;
+    QList<TileKey> m_Recent;
+
+    std::shared_ptr<const Config> m_Config;
+    std::atomic<quint64> m_Generation;
+
+    const ArithmBudget *m_Budget = nullptr;
+};
@@ -38,6 +38,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <deque>
 #include <exception>
 #include <functional>
@@ -52,6 +53,9 @@
 #include <utility>
 #include <vector>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
 
 namespace exprtk
 {
@@ -2237,6 +2241,22 @@ namespace exprtk
             return true;
          }
 
+         // Adopt an already scanned token list for str, bypassing scan_token.
+         inline void load(const std::string& str, const token_list_t& token_list)
+         {
+            base_itr_ = str.data();
+            s_itr_    = str.data() + str.size();
+            s_end_    = str.data() + str.size();
+
+            eof_token_.set_operator(token_t::e_eof,s_end_,s_end_,base_itr_);
+            token_list_ = token_list;
+         }
+
+         inline const token_list_t& tokens() const
+         {
+            return token_list_;
+         }
+
          inline bool empty() const
          {
             return token_list_.empty();
@@ -3189,7 +3209,8 @@ namespace exprtk
             using lexer::token_inserter::insert;
 
             commutative_inserter()
-            : lexer::token_inserter(2)
+            : lexer::token_inserter(2),
+              ignore_reserved_words_(false)
             {}
 
             inline void ignore_symbol(const std::string& symbol)
@@ -3197,6 +3218,11 @@ namespace exprtk
                ignore_set_.insert(symbol);
             }
 
+            inline void ignore_reserved_words()
+            {
+               ignore_reserved_words_ = true;
+            }
+
             inline int insert(const lexer::token& t0, const lexer::token& t1, lexer::token& new_token)
             {
                bool match         = false;
@@ -3206,7 +3232,7 @@ namespace exprtk
 
                if (t0.type == lexer::token::e_symbol)
                {
-                  if (ignore_set_.end() != ignore_set_.find(t0.value))
+                  if (ignored(t0.value))
                   {
                      return -1;
                   }
@@ -3218,7 +3244,7 @@ namespace exprtk
 
                if (t1.type == lexer::token::e_symbol)
                {
-                  if (ignore_set_.end() != ignore_set_.find(t1.value))
+                  if (ignored(t1.value))
                   {
                      return -1;
                   }
@@ -3241,7 +3267,25 @@ namespace exprtk
 
          private:
 
-            std::set<std::string,details::ilesscompare> ignore_set_;
+            typedef std::set<std::string,details::ilesscompare> symbol_set_t;
+
+            static const symbol_set_t& reserved_word_set()
+            {
+               static const symbol_set_t reserved_words(details::reserved_words,
+                                                        details::reserved_words + details::reserved_words_size);
+               return reserved_words;
+            }
+
+            inline bool ignored(const std::string& symbol) const
+            {
+               if (ignore_reserved_words_ && (reserved_word_set().end() != reserved_word_set().find(symbol)))
+                  return true;
+               else
+                  return (ignore_set_.end() != ignore_set_.find(symbol));
+            }
+
+            symbol_set_t ignore_set_;
+            bool ignore_reserved_words_;
          };
 
          class operator_joiner : public token_joiner
@@ -3644,32 +3688,9 @@ namespace exprtk
             using lexer::token_scanner::operator();
 
             sequence_validator()
-            : lexer::token_scanner(2)
-            {
-               add_invalid(lexer::token::e_number, lexer::token::e_number);
-               add_invalid(lexer::token::e_string, lexer::token::e_string);
-               add_invalid(lexer::token::e_number, lexer::token::e_string);
-               add_invalid(lexer::token::e_string, lexer::token::e_number);
-
-               add_invalid_set1(lexer::token::e_assign );
-               add_invalid_set1(lexer::token::e_shr    );
-               add_invalid_set1(lexer::token::e_shl    );
-               add_invalid_set1(lexer::token::e_lte    );
-               add_invalid_set1(lexer::token::e_ne     );
-               add_invalid_set1(lexer::token::e_gte    );
-               add_invalid_set1(lexer::token::e_lt     );
-               add_invalid_set1(lexer::token::e_gt     );
-               add_invalid_set1(lexer::token::e_eq     );
-               add_invalid_set1(lexer::token::e_comma  );
-               add_invalid_set1(lexer::token::e_add    );
-               add_invalid_set1(lexer::token::e_sub    );
-               add_invalid_set1(lexer::token::e_div    );
-               add_invalid_set1(lexer::token::e_mul    );
-               add_invalid_set1(lexer::token::e_mod    );
-               add_invalid_set1(lexer::token::e_pow    );
-               add_invalid_set1(lexer::token::e_colon  );
-               add_invalid_set1(lexer::token::e_ternary);
-            }
+            : lexer::token_scanner(2),
+              invalid_comb_(invalid_combinations())
+            {}
 
             bool result()
             {
@@ -3717,28 +3738,66 @@ namespace exprtk
 
          private:
 
-            void add_invalid(lexer::token::token_type base, lexer::token::token_type t)
+            // Shared by all validators, immutable once built
+            static const set_t& invalid_combinations()
+            {
+               static const set_t invalid_comb = load_invalid_combinations();
+               return invalid_comb;
+            }
+
+            static set_t load_invalid_combinations()
             {
-               invalid_comb_.insert(std::make_pair(base,t));
+               set_t s;
+
+               add_invalid(s, lexer::token::e_number, lexer::token::e_number);
+               add_invalid(s, lexer::token::e_string, lexer::token::e_string);
+               add_invalid(s, lexer::token::e_number, lexer::token::e_string);
+               add_invalid(s, lexer::token::e_string, lexer::token::e_number);
+
+               add_invalid_set1(s, lexer::token::e_assign );
+               add_invalid_set1(s, lexer::token::e_shr    );
+               add_invalid_set1(s, lexer::token::e_shl    );
+               add_invalid_set1(s, lexer::token::e_lte    );
+               add_invalid_set1(s, lexer::token::e_ne     );
+               add_invalid_set1(s, lexer::token::e_gte    );
+               add_invalid_set1(s, lexer::token::e_lt     );
+               add_invalid_set1(s, lexer::token::e_gt     );
+               add_invalid_set1(s, lexer::token::e_eq     );
+               add_invalid_set1(s, lexer::token::e_comma  );
+               add_invalid_set1(s, lexer::token::e_add    );
+               add_invalid_set1(s, lexer::token::e_sub    );
+               add_invalid_set1(s, lexer::token::e_div    );
+               add_invalid_set1(s, lexer::token::e_mul    );
+               add_invalid_set1(s, lexer::token::e_mod    );
+               add_invalid_set1(s, lexer::token::e_pow    );
+               add_invalid_set1(s, lexer::token::e_colon  );
+               add_invalid_set1(s, lexer::token::e_ternary);
+
+               return s;
             }
 
-            void add_invalid_set1(lexer::token::token_type t)
+            static void add_invalid(set_t& s, lexer::token::token_type base, lexer::token::token_type t)
             {
-               add_invalid(t, lexer::token::e_assign);
-               add_invalid(t, lexer::token::e_shr   );
-               add_invalid(t, lexer::token::e_shl   );
-               add_invalid(t, lexer::token::e_lte   );
-               add_invalid(t, lexer::token::e_ne    );
-               add_invalid(t, lexer::token::e_gte   );
-               add_invalid(t, lexer::token::e_lt    );
-               add_invalid(t, lexer::token::e_gt    );
-               add_invalid(t, lexer::token::e_eq    );
-               add_invalid(t, lexer::token::e_comma );
-               add_invalid(t, lexer::token::e_div   );
-               add_invalid(t, lexer::token::e_mul   );
-               add_invalid(t, lexer::token::e_mod   );
-               add_invalid(t, lexer::token::e_pow   );
-               add_invalid(t, lexer::token::e_colon );
+               s.insert(std::make_pair(base,t));
+            }
+
+            static void add_invalid_set1(set_t& s, lexer::token::token_type t)
+            {
+               add_invalid(s, t, lexer::token::e_assign);
+               add_invalid(s, t, lexer::token::e_shr   );
+               add_invalid(s, t, lexer::token::e_shl   );
+               add_invalid(s, t, lexer::token::e_lte   );
+               add_invalid(s, t, lexer::token::e_ne    );
+               add_invalid(s, t, lexer::token::e_gte   );
+               add_invalid(s, t, lexer::token::e_lt    );
+               add_invalid(s, t, lexer::token::e_gt    );
+               add_invalid(s, t, lexer::token::e_eq    );
+               add_invalid(s, t, lexer::token::e_comma );
+               add_invalid(s, t, lexer::token::e_div   );
+               add_invalid(s, t, lexer::token::e_mul   );
+               add_invalid(s, t, lexer::token::e_mod   );
+               add_invalid(s, t, lexer::token::e_pow   );
+               add_invalid(s, t, lexer::token::e_colon );
             }
 
             bool invalid_bracket_check(lexer::token::token_type base, lexer::token::token_type t)
@@ -3800,7 +3859,7 @@ namespace exprtk
                return false;
             }
 
-            set_t invalid_comb_;
+            const set_t& invalid_comb_;
             std::vector<std::pair<lexer::token,lexer::token> > error_list_;
          };
 
@@ -3817,26 +3876,9 @@ namespace exprtk
             using lexer::token_scanner::operator();
 
             sequence_validator_3tokens()
-            : lexer::token_scanner(3)
-            {
-               add_invalid(lexer::token::e_number, lexer::token::e_number, lexer::token::e_number);
-               add_invalid(lexer::token::e_string, lexer::token::e_string, lexer::token::e_string);
-               add_invalid(lexer::token::e_comma , lexer::token::e_comma , lexer::token::e_comma );
-
-               add_invalid(lexer::token::e_add   , lexer::token::e_add   , lexer::token::e_add   );
-               add_invalid(lexer::token::e_sub   , lexer::token::e_sub   , lexer::token::e_sub   );
-               add_invalid(lexer::token::e_div   , lexer::token::e_div   , lexer::token::e_div   );
-               add_invalid(lexer::token::e_mul   , lexer::token::e_mul   , lexer::token::e_mul   );
-               add_invalid(lexer::token::e_mod   , lexer::token::e_mod   , lexer::token::e_mod   );
-               add_invalid(lexer::token::e_pow   , lexer::token::e_pow   , lexer::token::e_pow   );
-
-               add_invalid(lexer::token::e_add   , lexer::token::e_sub   , lexer::token::e_add   );
-               add_invalid(lexer::token::e_sub   , lexer::token::e_add   , lexer::token::e_sub   );
-               add_invalid(lexer::token::e_div   , lexer::token::e_mul   , lexer::token::e_div   );
-               add_invalid(lexer::token::e_mul   , lexer::token::e_div   , lexer::token::e_mul   );
-               add_invalid(lexer::token::e_mod   , lexer::token::e_pow   , lexer::token::e_mod   );
-               add_invalid(lexer::token::e_pow   , lexer::token::e_mod   , lexer::token::e_pow   );
-            }
+            : lexer::token_scanner(3),
+              invalid_comb_(invalid_combinations())
+            {}
 
             bool result()
             {
@@ -3880,12 +3922,43 @@ namespace exprtk
 
          private:
 
-            void add_invalid(token_t t0, token_t t1, token_t t2)
+            static const set_t& invalid_combinations()
+            {
+               static const set_t invalid_comb = load_invalid_combinations();
+               return invalid_comb;
+            }
+
+            static set_t load_invalid_combinations()
+            {
+               set_t s;
+
+               add_invalid(s, lexer::token::e_number, lexer::token::e_number, lexer::token::e_number);
+               add_invalid(s, lexer::token::e_string, lexer::token::e_string, lexer::token::e_string);
+               add_invalid(s, lexer::token::e_comma , lexer::token::e_comma , lexer::token::e_comma );
+
+               add_invalid(s, lexer::token::e_add   , lexer::token::e_add   , lexer::token::e_add   );
+               add_invalid(s, lexer::token::e_sub   , lexer::token::e_sub   , lexer::token::e_sub   );
+               add_invalid(s, lexer::token::e_div   , lexer::token::e_div   , lexer::token::e_div   );
+               add_invalid(s, lexer::token::e_mul   , lexer::token::e_mul   , lexer::token::e_mul   );
+               add_invalid(s, lexer::token::e_mod   , lexer::token::e_mod   , lexer::token::e_mod   );
+               add_invalid(s, lexer::token::e_pow   , lexer::token::e_pow   , lexer::token::e_pow   );
+
+               add_invalid(s, lexer::token::e_add   , lexer::token::e_sub   , lexer::token::e_add   );
+               add_invalid(s, lexer::token::e_sub   , lexer::token::e_add   , lexer::token::e_sub   );
+               add_invalid(s, lexer::token::e_div   , lexer::token::e_mul   , lexer::token::e_div   );
+               add_invalid(s, lexer::token::e_mul   , lexer::token::e_div   , lexer::token::e_mul   );
+               add_invalid(s, lexer::token::e_mod   , lexer::token::e_pow   , lexer::token::e_mod   );
+               add_invalid(s, lexer::token::e_pow   , lexer::token::e_mod   , lexer::token::e_pow   );
+
+               return s;
+            }
+
+            static void add_invalid(set_t& s, token_t t0, token_t t1, token_t t2)
             {
-               invalid_comb_.insert(std::make_pair(t0,std::make_pair(t1,t2)));
+               s.insert(std::make_pair(t0,std::make_pair(t1,t2)));
             }
 
-            set_t invalid_comb_;
+            const set_t& invalid_comb_;
             std::vector<std::pair<lexer::token,lexer::token> > error_list_;
          };
 
@@ -4161,6 +4234,289 @@ namespace exprtk
       };
    }
 
+   class token_program
+   {
+   public:
+
+      /*
+         A compiled expression's node graph refers to symbol table storage
+         by address, so it cannot outlive the process that built it. What
+         can be persisted is the parser's input after lexing and all of the
+         token helper passes (joiners, inserters, modifiers and scanners):
+         re-running the parser over this program skips every pass that
+         precedes parse_corpus.
+
+         Binary layout (native byte order, all fields are 32-bit words):
+
+            header  : magic, version, byte order, options,
+                      token count, symbol count,
+                      expression size, string pool size
+            tokens  : {type, position, value offset, value size} * n
+            symbols : {offset, size} * n
+            pool    : expression text followed by token/symbol values
+
+         read() only copies out of the buffer, so it can be handed the
+         address of a read-only memory mapped file directly.
+      */
+
+      typedef unsigned int             word_t;
+      typedef lexer::token             token_t;
+      typedef std::vector<token_t>     token_list_t;
+      typedef std::vector<std::string> symbol_list_t;
+
+      enum { e_magic = 0x4B545845, e_version = 1, e_byte_order = 0x01020304 };
+
+      token_program()
+      : options_(0)
+      {}
+
+      inline void clear()
+      {
+         expression_.clear();
+         token_list_.clear();
+         symbol_list_.clear();
+         options_ = 0;
+      }
+
+      inline bool empty() const
+      {
+         return token_list_.empty();
+      }
+
+      inline void assign(const std::string& expression,
+                         const token_list_t& token_list,
+                         const std::size_t options)
+      {
+         expression_  = expression;
+         token_list_  = token_list;
+         options_     = options;
+         symbol_list_.clear();
+
+         std::set<std::string> symbol_set;
+
+         for (std::size_t i = 0; i < token_list_.size(); ++i)
+         {
+            const token_t& t = token_list_[i];
+
+            if (
+                 (token_t::e_symbol == t.type)               &&
+                 !details::is_reserved_symbol(t.value)       &&
+                 symbol_set.insert(t.value).second
+               )
+            {
+               symbol_list_.push_back(t.value);
+            }
+         }
+      }
+
+      inline const std::string& expression() const
+      {
+         return expression_;
+      }
+
+      inline const token_list_t& tokens() const
+      {
+         return token_list_;
+      }
+
+      // Non-reserved symbols referenced by the program, in first-use order.
+      inline const symbol_list_t& symbols() const
+      {
+         return symbol_list_;
+      }
+
+      inline std::size_t options() const
+      {
+         return options_;
+      }
+
+      inline void write(std::string& buffer) const
+      {
+         std::string pool = expression_;
+
+         std::vector<word_t> words;
+         words.reserve(header_words + token_list_.size() * token_words + symbol_list_.size() * symbol_words);
+
+         words.push_back(e_magic     );
+         words.push_back(e_version   );
+         words.push_back(e_byte_order);
+         words.push_back(static_cast<word_t>(options_           ));
+         words.push_back(static_cast<word_t>(token_list_.size() ));
+         words.push_back(static_cast<word_t>(symbol_list_.size()));
+         words.push_back(static_cast<word_t>(expression_.size() ));
+         words.push_back(0);
+
+         for (std::size_t i = 0; i < token_list_.size(); ++i)
+         {
+            const token_t& t = token_list_[i];
+
+            words.push_back(static_cast<word_t>(t.type));
+            words.push_back(static_cast<word_t>(t.position));
+            words.push_back(static_cast<word_t>(intern(pool,t.value)));
+            words.push_back(static_cast<word_t>(t.value.size()));
+         }
+
+         for (std::size_t i = 0; i < symbol_list_.size(); ++i)
+         {
+            words.push_back(static_cast<word_t>(intern(pool,symbol_list_[i])));
+            words.push_back(static_cast<word_t>(symbol_list_[i].size()));
+         }
+
+         words[header_words - 1] = static_cast<word_t>(pool.size());
+
+         buffer.resize(words.size() * sizeof(word_t) + pool.size());
+
+         std::memcpy(&buffer[0], &words[0], words.size() * sizeof(word_t));
+
+         if (!pool.empty())
+         {
+            std::memcpy(&buffer[words.size() * sizeof(word_t)], pool.data(), pool.size());
+         }
+      }
+
+      inline bool read(const char* data, const std::size_t size)
+      {
+         clear();
+
+         word_t header[header_words];
+
+         if ((0 == data) || (size < sizeof(header)))
+            return false;
+
+         std::memcpy(header, data, sizeof(header));
+
+         if (
+              (e_magic      != header[0]) ||
+              (e_version    != header[1]) ||
+              (e_byte_order != header[2])
+            )
+            return false;
+
+         const std::size_t token_count     = header[4];
+         const std::size_t symbol_count    = header[5];
+         const std::size_t expression_size = header[6];
+         const std::size_t pool_size       = header[7];
+
+         const std::size_t table_size = sizeof(word_t) *
+                                        (token_count  * token_words +
+                                         symbol_count * symbol_words);
+
+         if (
+              (expression_size > pool_size) ||
+              ((size - sizeof(header)) < table_size) ||
+              ((size - sizeof(header) - table_size) != pool_size)
+            )
+            return false;
+
+         const char* table = data  + sizeof(header);
+         const char* pool  = table + table_size;
+
+         word_t record[token_words];
+
+         token_list_.resize(token_count);
+
+         for (std::size_t i = 0; i < token_count; ++i)
+         {
+            std::memcpy(record, table, sizeof(record));
+            table += sizeof(record);
+
+            if ((record[2] > pool_size) || (record[3] > (pool_size - record[2])))
+            {
+               clear();
+               return false;
+            }
+
+            token_t& t = token_list_[i];
+
+            t.type     = static_cast<token_t::token_type>(record[0]);
+            t.position = record[1];
+            t.value.assign(pool + record[2], record[3]);
+         }
+
+         symbol_list_.resize(symbol_count);
+
+         for (std::size_t i = 0; i < symbol_count; ++i)
+         {
+            std::memcpy(record, table, sizeof(word_t) * symbol_words);
+            table += sizeof(word_t) * symbol_words;
+
+            if ((record[0] > pool_size) || (record[1] > (pool_size - record[0])))
+            {
+               clear();
+               return false;
+            }
+
+            symbol_list_[i].assign(pool + record[0], record[1]);
+         }
+
+         expression_.assign(pool, expression_size);
+         options_ = header[3];
+
+         return true;
+      }
+
+      // Only the expression text of a program written by write(), so that
+      // programs can be indexed without decoding their tokens.
+      static inline bool read_expression(const char* data, const std::size_t size, std::string& expression)
+      {
+         word_t header[header_words];
+
+         if ((0 == data) || (size < sizeof(header)))
+            return false;
+
+         std::memcpy(header, data, sizeof(header));
+
+         if (
+              (e_magic      != header[0]) ||
+              (e_version    != header[1]) ||
+              (e_byte_order != header[2])
+            )
+            return false;
+
+         const std::size_t token_count     = header[4];
+         const std::size_t symbol_count    = header[5];
+         const std::size_t expression_size = header[6];
+         const std::size_t pool_size       = header[7];
+
+         const std::size_t table_size = sizeof(word_t) *
+                                        (token_count  * token_words +
+                                         symbol_count * symbol_words);
+
+         if (
+              (expression_size > pool_size) ||
+              ((size - sizeof(header)) < table_size) ||
+              ((size - sizeof(header) - table_size) != pool_size)
+            )
+            return false;
+
+         expression.assign(data + sizeof(header) + table_size, expression_size);
+
+         return true;
+      }
+
+   private:
+
+      enum { header_words = 8, token_words = 4, symbol_words = 2 };
+
+      // Reuse the expression text for values that are substrings of it.
+      static inline std::size_t intern(std::string& pool, const std::string& value)
+      {
+         const std::size_t offset = pool.find(value);
+
+         if (std::string::npos != offset)
+            return offset;
+
+         pool += value;
+
+         return pool.size() - value.size();
+      }
+
+      std::string   expression_;
+      token_list_t  token_list_;
+      symbol_list_t symbol_list_;
+      std::size_t   options_;
+   };
+
    template <typename T>
    class vector_view
    {
@@ -4492,6 +4848,203 @@ namespace exprtk
       #endif
    };
 
+   struct loop_runtime_check
+   {
+      typedef unsigned long long int count_t;
+
+      enum loop_types
+      {
+         e_invalid           = 0,
+         e_for_loop          = 1,
+         e_while_loop        = 2,
+         e_repeat_until_loop = 4,
+         e_all_loops         = 7
+      };
+
+      enum violation_type
+      {
+         e_unknown         = 0,
+         e_iteration_count = 1,
+         e_runtime_check   = 2
+      };
+
+      struct violation_context
+      {
+         loop_types     loop;
+         violation_type violation;
+         count_t        iteration_count;
+      };
+
+      loop_runtime_check()
+      : loop_set           (e_all_loops),
+        max_loop_iterations(0),
+        check_interval     (1024)
+      {}
+
+      virtual ~loop_runtime_check()
+      {}
+
+      // Invoked once every check_interval iterations of a loop, eg: to
+      // test a wall-clock deadline or a cancellation request. Returning
+      // false terminates the loop with an e_runtime_check violation.
+      virtual bool check()
+      {
+         return true;
+      }
+
+      virtual void handle_runtime_violation(const violation_context&)
+      {
+         throw std::runtime_error("ExprTk Loop runtime violation.");
+      }
+
+      loop_types loop_set;
+      count_t    max_loop_iterations;
+      count_t    check_interval;
+   };
+
+   typedef loop_runtime_check* loop_runtime_check_ptr;
+
+   class expression_profile
+   {
+   public:
+
+      typedef unsigned long long int tick_t;
+
+      struct entry
+      {
+         entry()
+         : begin(0),
+           end  (0),
+           calls(0),
+           ticks(0)
+         {}
+
+         std::size_t begin; // [begin,end) of the source expression
+         std::size_t end;
+         std::string text;
+         tick_t      calls;
+         tick_t      ticks; // inclusive of nested entries
+      };
+
+      // Entries are referenced by the profiled nodes, hence a deque.
+      typedef std::deque<entry> entry_list_t;
+
+      inline const entry_list_t& entries() const
+      {
+         return entry_list_;
+      }
+
+      inline bool empty() const
+      {
+         return entry_list_.empty();
+      }
+
+      inline void reset()
+      {
+         for (std::size_t i = 0; i < entry_list_.size(); ++i)
+         {
+            entry_list_[i].calls = 0;
+            entry_list_[i].ticks = 0;
+         }
+      }
+
+      // Entries ordered by descending tick count
+      inline std::vector<const entry*> hottest() const
+      {
+         std::vector<const entry*> result;
+
+         for (std::size_t i = 0; i < entry_list_.size(); ++i)
+         {
+            result.push_back(&entry_list_[i]);
+         }
+
+         std::stable_sort(result.begin(), result.end(), hotter);
+
+         return result;
+      }
+
+      inline std::string to_json() const
+      {
+         const std::vector<const entry*> list = hottest();
+
+         std::string result = "[";
+
+         for (std::size_t i = 0; i < list.size(); ++i)
+         {
+            result += (i ? ",\n " : "\n ");
+            result += "{\"begin\":" + to_str(list[i]->begin) +
+                      ",\"end\":"   + to_str(list[i]->end  ) +
+                      ",\"calls\":" + to_str(list[i]->calls) +
+                      ",\"ticks\":" + to_str(list[i]->ticks) +
+                      ",\"text\":\"" + escape(list[i]->text) + "\"}";
+         }
+
+         return result + (list.empty() ? "]" : "\n]");
+      }
+
+   private:
+
+      inline entry& add(const std::size_t& begin, const std::size_t& end, const std::string& text)
+      {
+         entry_list_.push_back(entry());
+
+         entry& e = entry_list_.back();
+
+         e.begin = begin;
+         e.end   = end;
+         e.text  = text;
+
+         return e;
+      }
+
+      static inline bool hotter(const entry* e0, const entry* e1)
+      {
+         return e0->ticks > e1->ticks;
+      }
+
+      static inline std::string to_str(tick_t i)
+      {
+         std::string result;
+
+         do
+         {
+            result += static_cast<char>('0' + (i % 10));
+            i /= 10;
+         }
+         while (i);
+
+         std::reverse(result.begin(), result.end());
+
+         return result;
+      }
+
+      static inline std::string escape(const std::string& text)
+      {
+         std::string result;
+
+         for (std::size_t i = 0; i < text.size(); ++i)
+         {
+            const unsigned char c = static_cast<unsigned char>(text[i]);
+
+            if (('"' == c) || ('\\' == c))
+            {
+               result += '\\';
+               result += text[i];
+            }
+            else if (c < 0x20)
+               result += ' ';
+            else
+               result += text[i];
+         }
+
+         return result;
+      }
+
+      entry_list_t entry_list_;
+
+      template <typename> friend class parser;
+   };
+
    namespace details
    {
       enum operator_type
@@ -5038,7 +5591,7 @@ namespace exprtk
             e_vecopvecass   , e_vecfunc       , e_vecvecswap  , e_vecvecineq   ,
             e_vecvalineq    , e_valvecineq    , e_vecvecarith , e_vecvalarith  ,
             e_valvecarith   , e_vecunaryop    , e_break       , e_continue     ,
-            e_swap
+            e_swap          , e_profile
          };
 
          typedef T value_type;
@@ -6191,6 +6744,61 @@ namespace exprtk
          const bool consequent_deletable_;
       };
 
+      template <typename T>
+      struct flow_control
+      {
+         enum flow_state
+         {
+            e_normal   = 0,
+            e_break    = 1,
+            e_continue = 2,
+            e_return   = 3
+         };
+
+         flow_control()
+         : state(e_normal),
+           value(std::numeric_limits<T>::quiet_NaN())
+         {}
+
+         inline bool interrupted() const
+         {
+            return (e_normal != state);
+         }
+
+         // Consume a pending break/continue at the end of a loop
+         // iteration. Returns true when the loop must terminate,
+         // in which case result holds the loop's return value.
+         inline bool exit_loop(T& result)
+         {
+            switch (state)
+            {
+               case e_break    : result = value;
+                                 state  = e_normal;
+                                 return true;
+
+               case e_continue : state  = e_normal;
+                                 return false;
+
+               case e_return   : return true;
+
+               default         : return false;
+            }
+         }
+
+         // Each break, continue or return node owns a mode flag. It is
+         // set by the parser when the node is not in statement position
+         // and must therefore unwind the evaluation via an exception.
+         inline bool* create_mode()
+         {
+            mode_list.push_back(false);
+            return &mode_list.back();
+         }
+
+         flow_state state;
+         T value;
+         std::deque<bool> mode_list;
+      };
+
       #ifndef exprtk_disable_break_continue
       template <typename T>
       class break_exception
@@ -6214,9 +6822,11 @@ namespace exprtk
 
          typedef expression_node<T>* expression_ptr;
 
-         break_node(expression_ptr ret = expression_ptr(0))
+         break_node(flow_control<T>& fc, const bool& throw_mode, expression_ptr ret = expression_ptr(0))
          : return_(ret),
-           return_deletable_(branch_deletable(return_))
+           return_deletable_(branch_deletable(return_)),
+           flow_control_(&fc),
+           throw_mode_(&throw_mode)
          {}
 
         ~break_node()
@@ -6229,10 +6839,17 @@ namespace exprtk
 
          inline T value() const
          {
-            throw break_exception<T>(return_ ? return_->value() : std::numeric_limits<T>::quiet_NaN());
-            #ifndef _MSC_VER
-            return std::numeric_limits<T>::quiet_NaN();
-            #endif
+            const T result = return_ ? return_->value() : std::numeric_limits<T>::quiet_NaN();
+
+            if (*throw_mode_)
+            {
+               throw break_exception<T>(result);
+            }
+
+            flow_control_->state = flow_control<T>::e_break;
+            flow_control_->value = result;
+
+            return result;
          }
 
          inline typename expression_node<T>::node_type type() const
@@ -6244,6 +6861,8 @@ namespace exprtk
 
          expression_ptr return_;
          const bool return_deletable_;
+         flow_control<T>* flow_control_;
+         const bool* throw_mode_;
       };
 
       template <typename T>
@@ -6251,30 +6870,117 @@ namespace exprtk
       {
       public:
 
+         continue_node(flow_control<T>& fc, const bool& throw_mode)
+         : flow_control_(&fc),
+           throw_mode_(&throw_mode)
+         {}
+
          inline T value() const
          {
-            throw continue_exception();
-            #ifndef _MSC_VER
+            if (*throw_mode_)
+            {
+               throw continue_exception();
+            }
+
+            flow_control_->state = flow_control<T>::e_continue;
+
             return std::numeric_limits<T>::quiet_NaN();
-            #endif
          }
 
          inline typename expression_node<T>::node_type type() const
          {
             return expression_node<T>::e_break;
          }
+
+      private:
+
+         flow_control<T>* flow_control_;
+         const bool* throw_mode_;
       };
       #endif
 
+      class loop_runtime_checker
+      {
+      public:
+
+         typedef loop_runtime_check::count_t count_t;
+
+         loop_runtime_checker(loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0),
+                              const loop_runtime_check::loop_types lp_typ = loop_runtime_check::e_invalid)
+         : loop_runtime_check_(loop_rt_chk),
+           loop_type_         (lp_typ),
+           iteration_count_   (0),
+           next_check_        (0)
+         {}
+
+         inline void reset() const
+         {
+            if (loop_runtime_check_)
+            {
+               iteration_count_ = 0;
+               next_check_      = loop_runtime_check_->check_interval;
+            }
+         }
+
+         inline bool check() const
+         {
+            if (0 == loop_runtime_check_)
+               return true;
+
+            ++iteration_count_;
+
+            loop_runtime_check::violation_type violation = loop_runtime_check::e_unknown;
+
+            if (
+                 loop_runtime_check_->max_loop_iterations &&
+                 (iteration_count_ > loop_runtime_check_->max_loop_iterations)
+               )
+            {
+               violation = loop_runtime_check::e_iteration_count;
+            }
+            else if (iteration_count_ < next_check_)
+               return true;
+            else
+            {
+               next_check_ = iteration_count_ + loop_runtime_check_->check_interval;
+
+               if (loop_runtime_check_->check())
+                  return true;
+
+               violation = loop_runtime_check::e_runtime_check;
+            }
+
+            loop_runtime_check::violation_context context;
+            context.loop            = loop_type_;
+            context.violation       = violation;
+            context.iteration_count = iteration_count_;
+
+            loop_runtime_check_->handle_runtime_violation(context);
+
+            return false;
+         }
+
+      private:
+
+         loop_runtime_check_ptr loop_runtime_check_;
+         loop_runtime_check::loop_types loop_type_;
+         mutable count_t iteration_count_;
+         mutable count_t next_check_;
+      };
+
       template <typename T>
-      class while_loop_node : public expression_node<T>
+      class while_loop_node : public expression_node<T>,
+                              public loop_runtime_checker
       {
       public:
 
          typedef expression_node<T>* expression_ptr;
 
-         while_loop_node(expression_ptr condition, expression_ptr loop_body)
-         : condition_(condition),
+         while_loop_node(expression_ptr condition,
+                         expression_ptr loop_body,
+                         loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_while_loop),
+           condition_(condition),
            loop_body_(loop_body),
            condition_deletable_(branch_deletable(condition_)),
            loop_body_deletable_(branch_deletable(loop_body_))
@@ -6297,7 +7003,9 @@ namespace exprtk
          {
             T result = T(0);
 
-            while (is_true(condition_))
+            loop_runtime_checker::reset();
+
+            while (is_true(condition_) && loop_runtime_checker::check())
             {
                result = loop_body_->value();
             }
@@ -6319,14 +7027,18 @@ namespace exprtk
       };
 
       template <typename T>
-      class repeat_until_loop_node : public expression_node<T>
+      class repeat_until_loop_node : public expression_node<T>,
+                                     public loop_runtime_checker
       {
       public:
 
          typedef expression_node<T>* expression_ptr;
 
-         repeat_until_loop_node(expression_ptr condition, expression_ptr loop_body)
-         : condition_(condition),
+         repeat_until_loop_node(expression_ptr condition,
+                                expression_ptr loop_body,
+                                loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_repeat_until_loop),
+           condition_(condition),
            loop_body_(loop_body),
            condition_deletable_(branch_deletable(condition_)),
            loop_body_deletable_(branch_deletable(loop_body_))
@@ -6349,11 +7061,13 @@ namespace exprtk
          {
             T result = T(0);
 
+            loop_runtime_checker::reset();
+
             do
             {
                result = loop_body_->value();
             }
-            while (is_false(condition_));
+            while (is_false(condition_) && loop_runtime_checker::check());
 
             return result;
          }
@@ -6372,7 +7086,8 @@ namespace exprtk
       };
 
       template <typename T>
-      class for_loop_node : public expression_node<T>
+      class for_loop_node : public expression_node<T>,
+                            public loop_runtime_checker
       {
       public:
 
@@ -6381,8 +7096,10 @@ namespace exprtk
          for_loop_node(expression_ptr initialiser,
                        expression_ptr condition,
                        expression_ptr incrementor,
-                       expression_ptr loop_body)
-         : initialiser_(initialiser),
+                       expression_ptr loop_body,
+                       loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_for_loop),
+           initialiser_(initialiser),
            condition_  (condition  ),
            incrementor_(incrementor),
            loop_body_  (loop_body  ),
@@ -6419,12 +7136,14 @@ namespace exprtk
          {
             T result = T(0);
 
+            loop_runtime_checker::reset();
+
             if (initialiser_)
                initialiser_->value();
 
             if (incrementor_)
             {
-               while (is_true(condition_))
+               while (is_true(condition_) && loop_runtime_checker::check())
                {
                   result = loop_body_->value();
                   incrementor_->value();
@@ -6432,7 +7151,7 @@ namespace exprtk
             }
             else
             {
-               while (is_true(condition_))
+               while (is_true(condition_) && loop_runtime_checker::check())
                {
                   result = loop_body_->value();
                }
@@ -6460,17 +7179,23 @@ namespace exprtk
 
       #ifndef exprtk_disable_break_continue
       template <typename T>
-      class while_loop_bc_node : public expression_node<T>
+      class while_loop_bc_node : public expression_node<T>,
+                                 public loop_runtime_checker
       {
       public:
 
          typedef expression_node<T>* expression_ptr;
 
-         while_loop_bc_node(expression_ptr condition, expression_ptr loop_body)
-         : condition_(condition),
+         while_loop_bc_node(expression_ptr condition,
+                            expression_ptr loop_body,
+                            flow_control<T>* fc,
+                            loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_while_loop),
+           condition_(condition),
            loop_body_(loop_body),
            condition_deletable_(branch_deletable(condition_)),
-           loop_body_deletable_(branch_deletable(loop_body_))
+           loop_body_deletable_(branch_deletable(loop_body_)),
+           flow_control_(fc)
          {}
 
         ~while_loop_bc_node()
@@ -6490,11 +7215,18 @@ namespace exprtk
          {
             T result = T(0);
 
-            while (is_true(condition_))
+            loop_runtime_checker::reset();
+
+            while (is_true(condition_) && loop_runtime_checker::check())
             {
                try
                {
-                  result = loop_body_->value();
+                  const T body_result = loop_body_->value();
+
+                  if (!flow_control_->interrupted())
+                     result = body_result;
+                  else if (flow_control_->exit_loop(result))
+                     return result;
                }
                catch(const break_exception<T>& e)
                {
@@ -6518,20 +7250,27 @@ namespace exprtk
          expression_ptr loop_body_;
          const bool condition_deletable_;
          const bool loop_body_deletable_;
+         flow_control<T>* flow_control_;
       };
 
       template <typename T>
-      class repeat_until_loop_bc_node : public expression_node<T>
+      class repeat_until_loop_bc_node : public expression_node<T>,
+                                        public loop_runtime_checker
       {
       public:
 
          typedef expression_node<T>* expression_ptr;
 
-         repeat_until_loop_bc_node(expression_ptr condition, expression_ptr loop_body)
-         : condition_(condition),
+         repeat_until_loop_bc_node(expression_ptr condition,
+                                   expression_ptr loop_body,
+                                   flow_control<T>* fc,
+                                   loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_repeat_until_loop),
+           condition_(condition),
            loop_body_(loop_body),
            condition_deletable_(branch_deletable(condition_)),
-           loop_body_deletable_(branch_deletable(loop_body_))
+           loop_body_deletable_(branch_deletable(loop_body_)),
+           flow_control_(fc)
          {}
 
         ~repeat_until_loop_bc_node()
@@ -6551,11 +7290,18 @@ namespace exprtk
          {
             T result = T(0);
 
+            loop_runtime_checker::reset();
+
             do
             {
                try
                {
-                  result = loop_body_->value();
+                  const T body_result = loop_body_->value();
+
+                  if (!flow_control_->interrupted())
+                     result = body_result;
+                  else if (flow_control_->exit_loop(result))
+                     return result;
                }
                catch(const break_exception<T>& e)
                {
@@ -6564,7 +7310,7 @@ namespace exprtk
                catch(const continue_exception&)
                {}
             }
-            while (is_false(condition_));
+            while (is_false(condition_) && loop_runtime_checker::check());
 
             return result;
          }
@@ -6580,27 +7326,33 @@ namespace exprtk
          expression_ptr loop_body_;
          const bool condition_deletable_;
          const bool loop_body_deletable_;
+         flow_control<T>* flow_control_;
       };
 
       template <typename T>
-      class for_loop_bc_node : public expression_node<T>
+      class for_loop_bc_node : public expression_node<T>,
+                               public loop_runtime_checker
       {
       public:
 
          typedef expression_node<T>* expression_ptr;
 
          for_loop_bc_node(expression_ptr initialiser,
-                       expression_ptr condition,
-                       expression_ptr incrementor,
-                       expression_ptr loop_body)
-         : initialiser_(initialiser),
+                          expression_ptr condition,
+                          expression_ptr incrementor,
+                          expression_ptr loop_body,
+                          flow_control<T>* fc,
+                          loop_runtime_check_ptr loop_rt_chk = loop_runtime_check_ptr(0))
+         : loop_runtime_checker(loop_rt_chk, loop_runtime_check::e_for_loop),
+           initialiser_(initialiser),
            condition_  (condition  ),
            incrementor_(incrementor),
            loop_body_  (loop_body  ),
            initialiser_deletable_(branch_deletable(initialiser_)),
            condition_deletable_  (branch_deletable(condition_  )),
            incrementor_deletable_(branch_deletable(incrementor_)),
-           loop_body_deletable_  (branch_deletable(loop_body_  ))
+           loop_body_deletable_  (branch_deletable(loop_body_  )),
+           flow_control_(fc)
          {}
 
         ~for_loop_bc_node()
@@ -6630,16 +7382,23 @@ namespace exprtk
          {
             T result = T(0);
 
+            loop_runtime_checker::reset();
+
             if (initialiser_)
                initialiser_->value();
 
             if (incrementor_)
             {
-               while (is_true(condition_))
+               while (is_true(condition_) && loop_runtime_checker::check())
                {
                   try
                   {
-                     result = loop_body_->value();
+                     const T body_result = loop_body_->value();
+
+                     if (!flow_control_->interrupted())
+                        result = body_result;
+                     else if (flow_control_->exit_loop(result))
+                        return result;
                   }
                   catch(const break_exception<T>& e)
                   {
@@ -6653,11 +7412,16 @@ namespace exprtk
             }
             else
             {
-               while (is_true(condition_))
+               while (is_true(condition_) && loop_runtime_checker::check())
                {
                   try
                   {
-                     result = loop_body_->value();
+                     const T body_result = loop_body_->value();
+
+                     if (!flow_control_->interrupted())
+                        result = body_result;
+                     else if (flow_control_->exit_loop(result))
+                        return result;
                   }
                   catch(const break_exception<T>& e)
                   {
@@ -6686,6 +7450,7 @@ namespace exprtk
          const bool condition_deletable_  ;
          const bool incrementor_deletable_;
          const bool loop_body_deletable_  ;
+         flow_control<T>* flow_control_;
       };
       #endif
 
@@ -9483,6 +10248,81 @@ namespace exprtk
          std::vector<unsigned char> delete_branch_;
       };
 
+      template <typename T>
+      class vararg_multi_bc_node : public expression_node<T>
+      {
+      public:
+
+         typedef expression_node<T>* expression_ptr;
+
+         template <typename Allocator,
+                   template <typename, typename> class Sequence>
+         vararg_multi_bc_node(const Sequence<expression_ptr,Allocator>& arg_list,
+                              flow_control<T>& fc)
+         : flow_control_(&fc)
+         {
+            arg_list_     .resize(arg_list.size());
+            delete_branch_.resize(arg_list.size());
+
+            for (std::size_t i = 0; i < arg_list.size(); ++i)
+            {
+               if (arg_list[i])
+               {
+                       arg_list_[i] = arg_list[i];
+                  delete_branch_[i] = static_cast<unsigned char>(branch_deletable(arg_list_[i]) ? 1 : 0);
+               }
+               else
+               {
+                  arg_list_.clear();
+                  delete_branch_.clear();
+                  return;
+               }
+            }
+         }
+
+        ~vararg_multi_bc_node()
+         {
+            for (std::size_t i = 0; i < arg_list_.size(); ++i)
+            {
+               if (arg_list_[i] && delete_branch_[i])
+               {
+                  destroy_node(arg_list_[i]);
+               }
+            }
+         }
+
+         inline T value() const
+         {
+            if (arg_list_.empty())
+               return std::numeric_limits<T>::quiet_NaN();
+
+            const std::size_t last = arg_list_.size() - 1;
+
+            for (std::size_t i = 0; i < last; ++i)
+            {
+               arg_list_[i]->value();
+
+               // A break, continue or return was signalled by the
+               // current statement, skip the remainder of the sequence.
+               if (flow_control_->interrupted())
+                  return std::numeric_limits<T>::quiet_NaN();
+            }
+
+            return arg_list_[last]->value();
+         }
+
+         inline typename expression_node<T>::node_type type() const
+         {
+            return expression_node<T>::e_vararg;
+         }
+
+      private:
+
+         std::vector<expression_ptr> arg_list_;
+         std::vector<unsigned char> delete_branch_;
+         flow_control<T>* flow_control_;
+      };
+
       template <typename T, typename VarArgFunction>
       class vararg_varnode : public expression_node<T>
       {
@@ -11906,9 +12746,13 @@ namespace exprtk
          typedef results_context<T> results_context_t;
 
          return_node(const std::vector<typename gen_function_t::expression_ptr>& arg_list,
-                     results_context_t& rc)
+                     results_context_t& rc,
+                     flow_control<T>& fc,
+                     const bool& throw_mode)
          : gen_function_t  (arg_list),
-           results_context_(&rc)
+           results_context_(&rc),
+           flow_control_   (&fc),
+           throw_mode_     (&throw_mode)
          {}
 
          inline T value() const
@@ -11923,7 +12767,12 @@ namespace exprtk
                results_context_->
                   assign(parameter_list_t(gen_function_t::typestore_list_));
 
-               throw return_exception();
+               if (*throw_mode_)
+               {
+                  throw return_exception();
+               }
+
+               flow_control_->state = flow_control<T>::e_return;
             }
 
             return std::numeric_limits<T>::quiet_NaN();
@@ -11937,6 +12786,8 @@ namespace exprtk
       private:
 
          results_context_t* results_context_;
+         flow_control<T>*   flow_control_;
+         const bool*        throw_mode_;
       };
 
       template <typename T>
@@ -11947,8 +12798,9 @@ namespace exprtk
          typedef expression_node<T>* expression_ptr;
          typedef results_context<T>  results_context_t;
 
-         return_envelope_node(expression_ptr body, results_context_t& rc)
+         return_envelope_node(expression_ptr body, results_context_t& rc, flow_control<T>& fc)
          : results_context_(&rc  ),
+           flow_control_   (&fc  ),
            return_invoked_ (false),
            body_           (body ),
            body_deletable_ (branch_deletable(body_))
@@ -11969,7 +12821,16 @@ namespace exprtk
                return_invoked_ = false;
                results_context_->clear();
 
-               return body_->value();
+               const T result = body_->value();
+
+               if (flow_control<T>::e_return == flow_control_->state)
+               {
+                  flow_control_->state = flow_control<T>::e_normal;
+                  return_invoked_ = true;
+                  return std::numeric_limits<T>::quiet_NaN();
+               }
+
+               return result;
             }
             catch(const return_exception&)
             {
@@ -11991,12 +12852,93 @@ namespace exprtk
       private:
 
          results_context_t* results_context_;
+         flow_control<T>*   flow_control_;
          mutable bool       return_invoked_;
          expression_ptr     body_;
          const bool         body_deletable_;
       };
       #endif
 
+      struct profile_clock
+      {
+         typedef expression_profile::tick_t tick_t;
+
+         static inline tick_t now()
+         {
+            #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+            return __builtin_ia32_rdtsc();
+            #elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+            return __rdtsc();
+            #else
+            return static_cast<tick_t>(std::clock());
+            #endif
+         }
+      };
+
+      template <typename T>
+      class profile_node : public expression_node<T>
+      {
+      public:
+
+         typedef expression_node<T>* expression_ptr;
+         typedef expression_profile::entry entry_t;
+
+         profile_node(expression_ptr branch, entry_t* entry)
+         : entry_           (entry ),
+           branch_          (branch),
+           branch_deletable_(branch_deletable(branch_))
+         {}
+
+        ~profile_node()
+         {
+            if (branch_ && branch_deletable_)
+            {
+               destroy_node(branch_);
+            }
+         }
+
+         inline T value() const
+         {
+            // Accounts for evaluations left through an exception
+            const scoped_ticks st(*entry_);
+
+            return branch_->value();
+         }
+
+         inline typename expression_node<T>::node_type type() const
+         {
+            return expression_node<T>::e_profile;
+         }
+
+      private:
+
+         struct scoped_ticks
+         {
+            explicit scoped_ticks(entry_t& e)
+            : entry_(e),
+              start_(profile_clock::now())
+            {
+               ++entry_.calls;
+            }
+
+           ~scoped_ticks()
+            {
+               entry_.ticks += profile_clock::now() - start_;
+            }
+
+            entry_t& entry_;
+            const profile_clock::tick_t start_;
+
+         private:
+
+            scoped_ticks& operator=(const scoped_ticks&);
+         };
+
+         entry_t*       entry_;
+         expression_ptr branch_;
+         const bool     branch_deletable_;
+      };
+
       #define exprtk_define_unary_op(OpName)                    \
       template <typename T>                                     \
       struct OpName##_op                                        \
@@ -17785,6 +18727,8 @@ namespace exprtk
          : ref_count(0),
            expr     (0),
            results  (0),
+           flow     (0),
+           profile  (0),
            retinv_null(false),
            return_invoked(&retinv_null)
          {}
@@ -17793,6 +18737,8 @@ namespace exprtk
          : ref_count(1),
            expr     (e),
            results  (0),
+           flow     (0),
+           profile  (0),
            retinv_null(false),
            return_invoked(&retinv_null)
          {}
@@ -17834,6 +18780,16 @@ namespace exprtk
             {
                delete results;
             }
+
+            if (flow)
+            {
+               delete flow;
+            }
+
+            if (profile)
+            {
+               delete profile;
+            }
          }
 
          static inline control_block* create(expression_ptr e)
@@ -17861,6 +18817,8 @@ namespace exprtk
          expression_ptr expr;
          local_data_list_t local_data_list;
          results_context_t* results;
+         details::flow_control<T>* flow;
+         expression_profile* profile;
          bool  retinv_null;
          bool* return_invoked;
 
@@ -17992,6 +18950,26 @@ namespace exprtk
          return (*control_block_->return_invoked);
       }
 
+      // Populated when compiled with profiling enabled
+      inline const expression_profile& profile() const
+      {
+         if (control_block_->profile)
+            return (*control_block_->profile);
+         else
+         {
+            static const expression_profile null_profile;
+            return null_profile;
+         }
+      }
+
+      inline void reset_profile()
+      {
+         if (control_block_->profile)
+         {
+            control_block_->profile->reset();
+         }
+      }
+
    private:
 
       inline symtab_list_t get_symbol_table_list() const
@@ -18089,6 +19067,22 @@ namespace exprtk
          }
       }
 
+      inline void register_flow_control(details::flow_control<T>* fc)
+      {
+         if (control_block_ && fc)
+         {
+            control_block_->flow = fc;
+         }
+      }
+
+      inline void register_profile(expression_profile* ep)
+      {
+         if (control_block_ && ep)
+         {
+            control_block_->profile = ep;
+         }
+      }
+
       inline void set_retinvk(bool* retinvk_ptr)
       {
          if (control_block_)
@@ -19176,6 +20170,7 @@ namespace exprtk
          {
             parsing_return_stmt = false;
             parsing_break_stmt  = false;
+            parsing_statement   = false;
             return_stmt_present = false;
             side_effect_present = false;
             scope_depth         = 0;
@@ -19197,6 +20192,7 @@ namespace exprtk
 
          bool parsing_return_stmt;
          bool parsing_break_stmt;
+         bool parsing_statement;
          bool return_stmt_present;
          bool side_effect_present;
          bool type_check_enabled;
@@ -19454,7 +20450,8 @@ namespace exprtk
             e_collect_funcs        =  512,
             e_collect_assings      = 1024,
             e_disable_usr_on_rsrvd = 2048,
-            e_disable_zero_return  = 4096
+            e_disable_zero_return  = 4096,
+            e_profile_nodes        = 8192
          };
 
          enum settings_base_funcs
@@ -19633,6 +20630,18 @@ namespace exprtk
             return (*this);
          }
 
+         settings_store& enable_profiling()
+         {
+            enable_profiling_ = true;
+            return (*this);
+         }
+
+         settings_store& disable_profiling()
+         {
+            enable_profiling_ = false;
+            return (*this);
+         }
+
          bool replacer_enabled           () const { return enable_replacer_;           }
          bool commutative_check_enabled  () const { return enable_commutative_check_;  }
          bool joiner_enabled             () const { return enable_joiner_;             }
@@ -19646,6 +20655,7 @@ namespace exprtk
          bool vardef_disabled            () const { return disable_vardef_;            }
          bool rsrvd_sym_usr_disabled     () const { return disable_rsrvd_sym_usr_;     }
          bool zero_return_disabled       () const { return disable_zero_return_;       }
+         bool profiling_enabled          () const { return enable_profiling_;          }
 
          bool function_enabled(const std::string& function_name) const
          {
@@ -19952,6 +20962,7 @@ namespace exprtk
             disable_vardef_            = (compile_options & e_disable_vardef      ) == e_disable_vardef;
             disable_rsrvd_sym_usr_     = (compile_options & e_disable_usr_on_rsrvd) == e_disable_usr_on_rsrvd;
             disable_zero_return_       = (compile_options & e_disable_zero_return ) == e_disable_zero_return;
+            enable_profiling_          = (compile_options & e_profile_nodes       ) == e_profile_nodes;
          }
 
          std::string assign_opr_to_string(details::operator_type opr) const
@@ -20010,6 +21021,7 @@ namespace exprtk
          bool disable_vardef_;
          bool disable_rsrvd_sym_usr_;
          bool disable_zero_return_;
+         bool enable_profiling_;
 
          disabled_entity_set_t disabled_func_set_ ;
          disabled_entity_set_t disabled_ctrl_set_ ;
@@ -20027,7 +21039,16 @@ namespace exprtk
       : settings_(settings),
         resolve_unknown_symbol_(false),
         results_context_(0),
+        flow_control_(0),
+        profile_(0),
+        loop_runtime_check_(0),
         unknown_symbol_resolver_(reinterpret_cast<unknown_symbol_resolver*>(0)),
+        base_ops_map_     (operation_tables::shared().base_ops_map     ),
+        unary_op_map_     (operation_tables::shared().unary_op_map     ),
+        binary_op_map_    (operation_tables::shared().binary_op_map    ),
+        inv_binary_op_map_(operation_tables::shared().inv_binary_op_map),
+        sf3_map_          (operation_tables::shared().sf3_map          ),
+        sf4_map_          (operation_tables::shared().sf4_map          ),
         #ifdef _MSC_VER
         #pragma warning(push)
         #pragma warning (disable:4355)
@@ -20041,13 +21062,6 @@ namespace exprtk
       {
          init_precompilation();
 
-         load_operations_map           (base_ops_map_     );
-         load_unary_operations_map     (unary_op_map_     );
-         load_binary_operations_map    (binary_op_map_    );
-         load_inv_binary_operations_map(inv_binary_op_map_);
-         load_sf3_map                  (sf3_map_          );
-         load_sf4_map                  (sf4_map_          );
-
          expression_generator_.init_synthesize_map();
          expression_generator_.set_parser(*this);
          expression_generator_.set_uom(unary_op_map_);
@@ -20083,10 +21097,7 @@ namespace exprtk
 
          if (settings_.commutative_check_enabled())
          {
-            for (std::size_t i = 0; i < details::reserved_words_size; ++i)
-            {
-               commutative_inserter_.ignore_symbol(details::reserved_words[i]);
-            }
+            commutative_inserter_.ignore_reserved_words();
 
             helper_assembly_.token_inserter_list.clear();
             helper_assembly_.register_inserter(&commutative_inserter_);
@@ -20126,6 +21137,54 @@ namespace exprtk
       }
 
       inline bool compile(const std::string& expression_string, expression<T>& expr)
+      {
+         return compile_string(expression_string, expr, reinterpret_cast<token_program*>(0));
+      }
+
+      // As above, additionally capturing the validated token program on success.
+      inline bool compile(const std::string& expression_string, expression<T>& expr, token_program& program)
+      {
+         if (compile_string(expression_string, expr, &program))
+            return true;
+
+         program.clear();
+
+         return false;
+      }
+
+      // Rebuild an expression from a previously captured token program.
+      inline bool compile(const token_program& program, expression<T>& expr)
+      {
+         reset_compile_state();
+
+         if (program.empty())
+         {
+            set_error(
+               make_error(parser_error::e_syntax,
+                          "ERR202 - Empty token program!",
+                          exprtk_error_location));
+
+            return false;
+         }
+
+         if (program.options() != token_options())
+         {
+            set_error(
+               make_error(parser_error::e_syntax,
+                          "ERR203 - Token program was built with different compile options",
+                          exprtk_error_location));
+
+            return false;
+         }
+
+         lexer().load(program.expression(), program.tokens());
+
+         return parse_program(expr);
+      }
+
+   private:
+
+      inline void reset_compile_state()
       {
          state_          .reset();
          error_list_     .clear();
@@ -20133,9 +21192,31 @@ namespace exprtk
          synthesis_error_.clear();
          sem_            .cleanup();
 
-         return_cleanup();
+         return_cleanup ();
+         flow_cleanup   ();
+         profile_cleanup();
 
          expression_generator_.set_allocator(node_allocator_);
+      }
+
+      // Compile options which influence the token stream produced ahead of parsing.
+      inline std::size_t token_options() const
+      {
+         std::size_t options = 0;
+
+         if (settings_.replacer_enabled         ()) options |= settings_t::e_replacer;
+         if (settings_.joiner_enabled           ()) options |= settings_t::e_joiner;
+         if (settings_.numeric_check_enabled    ()) options |= settings_t::e_numeric_check;
+         if (settings_.bracket_check_enabled    ()) options |= settings_t::e_bracket_check;
+         if (settings_.sequence_check_enabled   ()) options |= settings_t::e_sequence_check;
+         if (settings_.commutative_check_enabled()) options |= settings_t::e_commutative_check;
+
+         return options;
+      }
+
+      inline bool compile_string(const std::string& expression_string, expression<T>& expr, token_program* program)
+      {
+         reset_compile_state();
 
          if (expression_string.empty())
          {
@@ -20168,6 +21249,16 @@ namespace exprtk
             return false;
          }
 
+         if (program)
+         {
+            program->assign(expression_string, lexer().tokens(), token_options());
+         }
+
+         return parse_program(expr);
+      }
+
+      inline bool parse_program(expression<T>& expr)
+      {
          symtab_store_.symtab_list_ = expr.get_symbol_table_list();
          dec_.clear();
 
@@ -20194,6 +21285,8 @@ namespace exprtk
 
             register_local_vars(expr);
             register_return_results(expr);
+            register_flow_control(expr);
+            register_profile(expr);
 
             return !(!expr);
          }
@@ -20213,14 +21306,18 @@ namespace exprtk
                destroy_node(e);
             }
 
-            dec_.clear    ();
-            sem_.cleanup  ();
-            return_cleanup();
+            dec_.clear     ();
+            sem_.cleanup   ();
+            return_cleanup ();
+            flow_cleanup   ();
+            profile_cleanup();
 
             return false;
          }
       }
 
+   public:
+
       inline expression_t compile(const std::string& expression_string, symbol_table_t& symtab)
       {
          expression_t expr;
@@ -20444,6 +21541,16 @@ namespace exprtk
          enable_unknown_symbol_resolver(&usr);
       }
 
+      inline void register_loop_runtime_check(loop_runtime_check& lrtchk)
+      {
+         loop_runtime_check_ = &lrtchk;
+      }
+
+      inline void clear_loop_runtime_check()
+      {
+         loop_runtime_check_ = loop_runtime_check_ptr(0);
+      }
+
       inline void disable_unknown_symbol_resolver()
       {
          resolve_unknown_symbol_  = false;
@@ -20532,13 +21639,15 @@ namespace exprtk
          lexer::token begin_token;
          lexer::token   end_token;
 
+         const flow_mark fm = mark_flow();
+
          for ( ; ; )
          {
             state_.side_effect_present = false;
 
             begin_token = current_token();
 
-            expression_node_ptr arg = parse_expression();
+            expression_node_ptr arg = parse_statement();
 
             if (0 == arg)
             {
@@ -20593,7 +21702,7 @@ namespace exprtk
             dec_.final_stmt_return_ = true;
          }
 
-         const expression_node_ptr result = simplify(arg_list,side_effect_list);
+         const expression_node_ptr result = simplify(arg_list, side_effect_list, false, flow_pending(fm));
 
          sdd.delete_ptr = (0 == result);
 
@@ -20637,8 +21746,22 @@ namespace exprtk
          details::operator_type operation;
       };
 
+      inline expression_node_ptr parse_statement()
+      {
+         const lexer::token begin_token = current_token();
+
+         state_.parsing_statement = true;
+
+         return profile(parse_expression(), begin_token);
+      }
+
       inline expression_node_ptr parse_expression(precedence_level precedence = e_level00)
       {
+         const bool statement = state_.parsing_statement;
+         const flow_mark fm   = mark_flow();
+
+         state_.parsing_statement = false;
+
          expression_node_ptr expression = parse_branch(precedence);
 
          if (0 == expression)
@@ -20774,6 +21897,9 @@ namespace exprtk
 
             next_token();
 
+            // The expression parsed so far becomes an operand.
+            flow_throw_mode(fm);
+
             expression_node_ptr right_branch   = error_node();
             expression_node_ptr new_expression = error_node();
 
@@ -20875,6 +22001,11 @@ namespace exprtk
             }
          }
 
+         if (!statement)
+         {
+            flow_throw_mode(fm);
+         }
+
          return expression;
       }
 
@@ -21311,7 +22442,7 @@ namespace exprtk
 
       inline expression_node_ptr parse_base_operation()
       {
-         typedef std::pair<base_ops_map_t::iterator,base_ops_map_t::iterator> map_range_t;
+         typedef std::pair<base_ops_map_t::const_iterator,base_ops_map_t::const_iterator> map_range_t;
 
          const std::string operation_name   = current_token().value;
          const token_t     diagnostic_token = current_token();
@@ -21336,7 +22467,7 @@ namespace exprtk
 
          if ((parameter_count > 0) && (parameter_count <= MaxNumberofParameters))
          {
-            for (base_ops_map_t::iterator itr = itr_range.first; itr != itr_range.second; ++itr)
+            for (base_ops_map_t::const_iterator itr = itr_range.first; itr != itr_range.second; ++itr)
             {
                const details::base_operation_t& operation = itr->second;
 
@@ -21394,7 +22525,7 @@ namespace exprtk
                           exprtk_error_location));
             result = false;
          }
-         else if (0 == (consequent = parse_expression()))
+         else if (0 == (consequent = parse_statement()))
          {
             set_error(
                make_error(parser_error::e_syntax,
@@ -21412,7 +22543,7 @@ namespace exprtk
                           exprtk_error_location));
             result = false;
          }
-         else if (0 == (alternative = parse_expression()))
+         else if (0 == (alternative = parse_statement()))
          {
             set_error(
                make_error(parser_error::e_syntax,
@@ -21499,7 +22630,7 @@ namespace exprtk
                next_token();
             }
 
-            if (0 != (consequent = parse_expression()))
+            if (0 != (consequent = parse_statement()))
             {
                if (!token_is(token_t::e_eof))
                {
@@ -21556,7 +22687,7 @@ namespace exprtk
                      result = false;
                   }
                }
-               else if (0 != (alternative = parse_expression()))
+               else if (0 != (alternative = parse_statement()))
                {
                   if (!token_is(token_t::e_eof))
                   {
@@ -21709,7 +22840,7 @@ namespace exprtk
 
             result = false;
          }
-         else if (0 == (consequent = parse_expression()))
+         else if (0 == (consequent = parse_statement()))
          {
             set_error(
                make_error(parser_error::e_syntax,
@@ -21729,7 +22860,7 @@ namespace exprtk
 
             result = false;
          }
-         else if (0 == (alternative = parse_expression()))
+         else if (0 == (alternative = parse_statement()))
          {
             set_error(
                make_error(parser_error::e_syntax,
@@ -21822,6 +22953,8 @@ namespace exprtk
 
          brkcnt_list_.push_front(false);
 
+         const flow_mark fm = mark_flow();
+
          if (result)
          {
             if (0 == (branch = parse_multi_sequence("while-loop")))
@@ -21834,7 +22967,8 @@ namespace exprtk
             }
             else if (0 == (result_node = expression_generator_.while_loop(condition,
                                                                           branch,
-                                                                          brkcnt_list_.front())))
+                                                                          brkcnt_list_.front() ||
+                                                                          return_pending(fm))))
             {
                set_error(
                   make_error(parser_error::e_syntax,
@@ -21857,7 +22991,12 @@ namespace exprtk
             return error_node();
          }
          else
+         {
+            brkcnt_list_.pop_front();
+            bind_flow(fm);
+
             return result_node;
+         }
       }
 
       inline expression_node_ptr parse_repeat_until_loop()
@@ -21874,6 +23013,8 @@ namespace exprtk
 
          brkcnt_list_.push_front(false);
 
+         const flow_mark fm = mark_flow();
+
          if (details::imatch(current_token().value,"until"))
          {
             next_token();
@@ -21887,11 +23028,13 @@ namespace exprtk
 
             scoped_bool_or_restorer sbr(state_.side_effect_present);
 
+            const flow_mark body_fm = mark_flow();
+
             for ( ; ; )
             {
                state_.side_effect_present = false;
 
-               expression_node_ptr arg = parse_expression();
+               expression_node_ptr arg = parse_statement();
 
                if (0 == arg)
                   return error_node();
@@ -21928,7 +23071,7 @@ namespace exprtk
                }
             }
 
-            branch = simplify(arg_list,side_effect_list);
+            branch = simplify(arg_list, side_effect_list, false, flow_pending(body_fm));
 
             sdd.delete_ptr = (0 == branch);
 
@@ -21993,7 +23136,7 @@ namespace exprtk
          expression_node_ptr result;
 
          result = expression_generator_
-                     .repeat_until_loop(condition, branch, brkcnt_list_.front());
+                     .repeat_until_loop(condition, branch, brkcnt_list_.front() || return_pending(fm));
 
          if (0 == result)
          {
@@ -22012,6 +23155,8 @@ namespace exprtk
          else
          {
             brkcnt_list_.pop_front();
+            bind_flow(fm);
+
             return result;
          }
       }
@@ -22025,6 +23170,7 @@ namespace exprtk
 
          scope_element* se = 0;
          bool result       = true;
+         flow_mark fm      = mark_flow();
 
          next_token();
 
@@ -22203,6 +23349,8 @@ namespace exprtk
          {
             brkcnt_list_.push_front(false);
 
+            fm = mark_flow();
+
             if (0 == (loop_body = parse_multi_sequence("for-loop")))
             {
                set_error(
@@ -22241,8 +23389,10 @@ namespace exprtk
                                               condition,
                                               incrementor,
                                               loop_body,
-                                              brkcnt_list_.front());
+                                              brkcnt_list_.front() ||
+                                              return_pending(fm));
             brkcnt_list_.pop_front();
+            bind_flow(fm);
 
             return result_node;
          }
@@ -22309,7 +23459,7 @@ namespace exprtk
                return error_node();
             }
 
-            expression_node_ptr consequent = parse_expression();
+            expression_node_ptr consequent = parse_statement();
 
             if (0 == consequent)
                return error_node();
@@ -22355,7 +23505,7 @@ namespace exprtk
                if (token_is(token_t::e_lcrlbracket,prsrhlpr_t::e_hold))
                   default_statement = parse_multi_sequence("switch-default");
                else
-                  default_statement = parse_expression();
+                  default_statement = parse_statement();
 
                if (0 == default_statement)
                   return error_node();
@@ -22666,7 +23816,8 @@ namespace exprtk
                 template <typename, typename> class Sequence>
       inline expression_node_ptr simplify(Sequence<expression_node_ptr,Allocator1>& expression_list,
                                           Sequence<bool,Allocator2>& side_effect_list,
-                                          const bool specialise_on_final_type = false)
+                                          const bool specialise_on_final_type = false,
+                                          const bool flow_control_present = false)
       {
          if (expression_list.empty())
             return error_node();
@@ -22739,6 +23890,8 @@ namespace exprtk
             return expression_list[0];
          else if (specialise_on_final_type && is_generally_string_node(expression_list.back()))
             return expression_generator_.vararg_function(details::e_smulti,expression_list);
+         else if (flow_control_present)
+            return expression_generator_.multi_sequence_bc(expression_list);
          else
             return expression_generator_.vararg_function(details::e_multi,expression_list);
       }
@@ -22783,11 +23936,13 @@ namespace exprtk
 
          scoped_bool_or_restorer sbr(state_.side_effect_present);
 
+         const flow_mark fm = mark_flow();
+
          for ( ; ; )
          {
             state_.side_effect_present = false;
 
-            expression_node_ptr arg = parse_expression();
+            expression_node_ptr arg = parse_statement();
 
             if (0 == arg)
                return error_node();
@@ -22817,7 +23972,19 @@ namespace exprtk
                break;
          }
 
-         result = simplify(arg_list,side_effect_list,source.empty());
+         const bool specialise_on_final_type = source.empty();
+
+         if (
+              specialise_on_final_type &&
+              flow_pending(fm)         &&
+              is_generally_string_node(arg_list.back())
+            )
+         {
+            // String sequences do not observe the flow control state.
+            flow_throw_mode(fm);
+         }
+
+         result = simplify(arg_list, side_effect_list, specialise_on_final_type, flow_pending(fm));
 
          sdd.delete_ptr = (0 == result);
          return result;
@@ -24102,7 +25269,8 @@ namespace exprtk
 
             state_.activate_side_effect("parse_break_statement()");
 
-            return node_allocator_.allocate<details::break_node<T> >(return_expr);
+            return node_allocator_.allocate_rrr<details::break_node<T> >
+                                       (flow_ctrl(), flow_mode(false), return_expr);
          }
          else
          {
@@ -24125,7 +25293,8 @@ namespace exprtk
             brkcnt_list_.front() = true;
             state_.activate_side_effect("parse_continue_statement()");
 
-            return node_allocator_.allocate<details::continue_node<T> >();
+            return node_allocator_.allocate_rr<details::continue_node<T> >
+                                       (flow_ctrl(), flow_mode(false));
          }
          else
          {
@@ -25726,6 +26895,8 @@ namespace exprtk
          #endif
          else if (token_t::e_lbracket == current_token().type)
          {
+            const lexer::token begin_token = current_token();
+
             next_token();
 
             if (0 == (branch = parse_expression()))
@@ -25748,6 +26919,8 @@ namespace exprtk
 
                return error_node();
             }
+
+            branch = profile(branch, begin_token);
          }
          else if (token_t::e_lsqrbracket == current_token().type)
          {
@@ -25869,13 +27042,26 @@ namespace exprtk
 
          inline void init_synthesize_map()
          {
+            synthesize_map_ = &shared_synthesize_map();
+         }
+
+         static inline const synthesize_map_t& shared_synthesize_map()
+         {
+            static const synthesize_map_t synthesize_map = load_synthesize_map();
+            return synthesize_map;
+         }
+
+         static inline synthesize_map_t load_synthesize_map()
+         {
+            synthesize_map_t synthesize_map;
+
             #ifndef exprtk_disable_enhanced_features
-            synthesize_map_["(v)o(v)"] = synthesize_vov_expression::process;
-            synthesize_map_["(c)o(v)"] = synthesize_cov_expression::process;
-            synthesize_map_["(v)o(c)"] = synthesize_voc_expression::process;
+            synthesize_map["(v)o(v)"] = synthesize_vov_expression::process;
+            synthesize_map["(c)o(v)"] = synthesize_cov_expression::process;
+            synthesize_map["(v)o(c)"] = synthesize_voc_expression::process;
 
-            #define register_synthezier(S)                      \
-            synthesize_map_[S ::node_type::id()] = S ::process; \
+            #define register_synthezier(S)                     \
+            synthesize_map[S ::node_type::id()] = S ::process; \
 
             register_synthezier(synthesize_vovov_expression0)
             register_synthezier(synthesize_vovov_expression1)
@@ -25937,7 +27123,11 @@ namespace exprtk
             register_synthezier(synthesize_covocov_expression4)
             register_synthezier(synthesize_vocovoc_expression4)
             register_synthezier(synthesize_covovoc_expression4)
+
+            #undef register_synthezier
             #endif
+
+            return synthesize_map;
          }
 
          inline void set_parser(parser_t& p)
@@ -25945,27 +27135,27 @@ namespace exprtk
             parser_ = &p;
          }
 
-         inline void set_uom(unary_op_map_t& unary_op_map)
+         inline void set_uom(const unary_op_map_t& unary_op_map)
          {
             unary_op_map_ = &unary_op_map;
          }
 
-         inline void set_bom(binary_op_map_t& binary_op_map)
+         inline void set_bom(const binary_op_map_t& binary_op_map)
          {
             binary_op_map_ = &binary_op_map;
          }
 
-         inline void set_ibom(inv_binary_op_map_t& inv_binary_op_map)
+         inline void set_ibom(const inv_binary_op_map_t& inv_binary_op_map)
          {
             inv_binary_op_map_ = &inv_binary_op_map;
          }
 
-         inline void set_sf3m(sf3_map_t& sf3_map)
+         inline void set_sf3m(const sf3_map_t& sf3_map)
          {
             sf3_map_ = &sf3_map;
          }
 
-         inline void set_sf4m(sf4_map_t& sf4_map)
+         inline void set_sf4m(const sf4_map_t& sf4_map)
          {
             sf4_map_ = &sf4_map;
          }
@@ -25987,7 +27177,7 @@ namespace exprtk
 
          inline bool valid_operator(const details::operator_type& operation, binary_functor_t& bop)
          {
-            typename binary_op_map_t::iterator bop_itr = binary_op_map_->find(operation);
+            typename binary_op_map_t::const_iterator bop_itr = binary_op_map_->find(operation);
 
             if ((*binary_op_map_).end() == bop_itr)
                return false;
@@ -25999,7 +27189,7 @@ namespace exprtk
 
          inline bool valid_operator(const details::operator_type& operation, unary_functor_t& uop)
          {
-            typename unary_op_map_t::iterator uop_itr = unary_op_map_->find(operation);
+            typename unary_op_map_t::const_iterator uop_itr = unary_op_map_->find(operation);
 
             if ((*unary_op_map_).end() == uop_itr)
                return false;
@@ -26829,6 +28019,19 @@ namespace exprtk
          }
          #endif
 
+         inline loop_runtime_check_ptr get_loop_runtime_check(const loop_runtime_check::loop_types loop_type) const
+         {
+            if (
+                 parser_->loop_runtime_check_ &&
+                 (loop_type == (parser_->loop_runtime_check_->loop_set & loop_type))
+               )
+            {
+               return parser_->loop_runtime_check_;
+            }
+
+            return loop_runtime_check_ptr(0);
+         }
+
          inline expression_node_ptr while_loop(expression_node_ptr& condition,
                                                expression_node_ptr& branch,
                                                const bool brkcont = false) const
@@ -26854,10 +28057,13 @@ namespace exprtk
                return branch;
             }
             else if (!brkcont)
-               return node_allocator_->allocate<while_loop_node_t>(condition,branch);
+               return node_allocator_->allocate<while_loop_node_t>
+                                       (condition, branch, get_loop_runtime_check(loop_runtime_check::e_while_loop));
             #ifndef exprtk_disable_break_continue
             else
-               return node_allocator_->allocate<while_loop_bc_node_t>(condition,branch);
+               return node_allocator_->allocate<while_loop_bc_node_t>
+                                       (condition, branch, &parser_->flow_ctrl(),
+                                        get_loop_runtime_check(loop_runtime_check::e_while_loop));
             #else
                return error_node();
             #endif
@@ -26891,10 +28097,13 @@ namespace exprtk
                return branch;
             }
             else if (!brkcont)
-               return node_allocator_->allocate<repeat_until_loop_node_t>(condition,branch);
+               return node_allocator_->allocate<repeat_until_loop_node_t>
+                                       (condition, branch, get_loop_runtime_check(loop_runtime_check::e_repeat_until_loop));
             #ifndef exprtk_disable_break_continue
             else
-               return node_allocator_->allocate<repeat_until_loop_bc_node_t>(condition,branch);
+               return node_allocator_->allocate<repeat_until_loop_bc_node_t>
+                                       (condition, branch, &parser_->flow_ctrl(),
+                                        get_loop_runtime_check(loop_runtime_check::e_repeat_until_loop));
             #else
                return error_node();
             #endif
@@ -26937,7 +28146,8 @@ namespace exprtk
                                          initialiser,
                                          condition,
                                          incrementor,
-                                         loop_body
+                                         loop_body,
+                                         get_loop_runtime_check(loop_runtime_check::e_for_loop)
                                        );
 
             #ifndef exprtk_disable_break_continue
@@ -26947,7 +28157,9 @@ namespace exprtk
                                          initialiser,
                                          condition,
                                          incrementor,
-                                         loop_body
+                                         loop_body,
+                                         &parser_->flow_ctrl(),
+                                         get_loop_runtime_check(loop_runtime_check::e_for_loop)
                                        );
             #else
             return error_node();
@@ -27559,6 +28771,22 @@ namespace exprtk
                return error_node();
          }
 
+         template <typename Allocator,
+                   template <typename, typename> class Sequence>
+         inline expression_node_ptr multi_sequence_bc(Sequence<expression_node_ptr,Allocator>& arg_list)
+         {
+            if (!all_nodes_valid(arg_list))
+            {
+               details::free_all_nodes(*node_allocator_,arg_list);
+
+               return error_node();
+            }
+
+            typedef details::vararg_multi_bc_node<Type> alloc_type;
+
+            return node_allocator_->allocate_rr<alloc_type>(arg_list, parser_->flow_ctrl());
+         }
+
          template <typename Allocator,
                    template <typename, typename> class Sequence>
          inline expression_node_ptr vararg_function(const details::operator_type& operation, Sequence<expression_node_ptr,Allocator>& arg_list)
@@ -27799,7 +29027,10 @@ namespace exprtk
             typedef details::return_node<Type> alloc_type;
 
             expression_node_ptr result = node_allocator_->
-                                            allocate_rr<alloc_type>(arg_list,parser_->results_ctx());
+                                            allocate_rrrr<alloc_type>(arg_list,
+                                                                      parser_->results_ctx(),
+                                                                      parser_->flow_ctrl(),
+                                                                      parser_->flow_mode(true));
 
             alloc_type* return_node_ptr = static_cast<alloc_type*>(result);
 
@@ -27825,7 +29056,7 @@ namespace exprtk
             typedef details::return_envelope_node<Type> alloc_type;
 
             expression_node_ptr result = node_allocator_->
-                                            allocate_cr<alloc_type>(body,(*rc));
+                                            allocate_rrr<alloc_type>(body, (*rc), parser_->flow_ctrl());
 
             return_invoked = static_cast<alloc_type*>(result)->retinvk_ptr();
 
@@ -29485,9 +30716,9 @@ namespace exprtk
 
             const std::string node_id = branch_to_id(branch);
 
-            const typename synthesize_map_t::iterator itr = synthesize_map_.find(node_id);
+            const typename synthesize_map_t::const_iterator itr = synthesize_map_->find(node_id);
 
-            if (synthesize_map_.end() != itr)
+            if (synthesize_map_->end() != itr)
             {
                result = itr->second((*this), operation, branch);
 
@@ -34996,12 +36227,12 @@ namespace exprtk
 
          bool                     strength_reduction_enabled_;
          details::node_allocator* node_allocator_;
-         synthesize_map_t         synthesize_map_;
-         unary_op_map_t*          unary_op_map_;
-         binary_op_map_t*         binary_op_map_;
-         inv_binary_op_map_t*     inv_binary_op_map_;
-         sf3_map_t*               sf3_map_;
-         sf4_map_t*               sf4_map_;
+         const synthesize_map_t*    synthesize_map_;
+         const unary_op_map_t*      unary_op_map_;
+         const binary_op_map_t*     binary_op_map_;
+         const inv_binary_op_map_t* inv_binary_op_map_;
+         const sf3_map_t*           sf3_map_;
+         const sf4_map_t*           sf4_map_;
          parser_t*                parser_;
       };
 
@@ -35091,7 +36322,106 @@ namespace exprtk
          results_context_ = 0;
       }
 
-      inline void load_unary_operations_map(unary_op_map_t& m)
+      inline void register_flow_control(expression<T>& e)
+      {
+         e.register_flow_control(flow_control_);
+         flow_control_ = 0;
+
+         brkcnt_mode_list_.clear();
+         return_mode_list_.clear();
+      }
+
+      inline void register_profile(expression<T>& e)
+      {
+         e.register_profile(profile_);
+         profile_ = 0;
+      }
+
+      inline void profile_cleanup()
+      {
+         if (profile_)
+         {
+            delete profile_;
+            profile_ = 0;
+         }
+      }
+
+      // Attributes the evaluation cost of a statement or bracketed
+      // sub-expression to the source range [begin_token, current token).
+      // Trivial and vector/string valued nodes are left as they are,
+      // as generators rely on their concrete types.
+      inline expression_node_ptr profile(expression_node_ptr node, const lexer::token& begin_token)
+      {
+         if (
+              (0 == node)                                  ||
+              !settings_.profiling_enabled()               ||
+              details::is_constant_node             (node) ||
+              details::is_variable_node             (node) ||
+              details::is_vector_elem_node          (node) ||
+              details::is_rebasevector_elem_node    (node) ||
+              details::is_rebasevector_celem_node   (node) ||
+              details::is_null_node                 (node) ||
+              details::is_break_node                (node) ||
+              details::is_continue_node             (node) ||
+              details::is_return_node               (node) ||
+              details::is_ivector_node              (node) ||
+              details::is_generally_string_node     (node)
+            )
+            return node;
+
+         std::string text = lexer().substr(begin_token.position, current_token().position);
+
+         while (!text.empty() && details::is_whitespace(details::back(text)))
+         {
+            text.erase(text.size() - 1);
+         }
+
+         for (std::size_t i = 0; i < text.size(); ++i)
+         {
+            if (details::is_whitespace(text[i])) text[i] = ' ';
+         }
+
+         if (0 == profile_)
+         {
+            profile_ = new expression_profile();
+         }
+
+         expression_profile::entry* entry = &profile_->add(begin_token.position, begin_token.position + text.size(), text);
+
+         return node_allocator_.allocate<details::profile_node<T> >(node, entry);
+      }
+
+      // Operator tables are immutable once loaded, hence a single lazily
+      // initialised instance is shared by all parsers of a given type.
+      // Note: prior to C++11 the first parser must be constructed before
+      // any concurrent parser construction takes place.
+      struct operation_tables
+      {
+         operation_tables()
+         {
+            details::load_operations_map  (base_ops_map     );
+            load_unary_operations_map     (unary_op_map     );
+            load_binary_operations_map    (binary_op_map    );
+            load_inv_binary_operations_map(inv_binary_op_map);
+            load_sf3_map                  (sf3_map          );
+            load_sf4_map                  (sf4_map          );
+         }
+
+         static inline const operation_tables& shared()
+         {
+            static const operation_tables tables;
+            return tables;
+         }
+
+         base_ops_map_t      base_ops_map;
+         unary_op_map_t      unary_op_map;
+         binary_op_map_t     binary_op_map;
+         inv_binary_op_map_t inv_binary_op_map;
+         sf3_map_t           sf3_map;
+         sf4_map_t           sf4_map;
+      };
+
+      static inline void load_unary_operations_map(unary_op_map_t& m)
       {
          #define register_unary_op(Op,UnaryFunctor)             \
          m.insert(std::make_pair(Op,UnaryFunctor<T>::process)); \
@@ -35138,7 +36468,7 @@ namespace exprtk
          #undef register_unary_op
       }
 
-      inline void load_binary_operations_map(binary_op_map_t& m)
+      static inline void load_binary_operations_map(binary_op_map_t& m)
       {
          typedef typename binary_op_map_t::value_type value_type;
 
@@ -35166,7 +36496,7 @@ namespace exprtk
          #undef register_binary_op
       }
 
-      inline void load_inv_binary_operations_map(inv_binary_op_map_t& m)
+      static inline void load_inv_binary_operations_map(inv_binary_op_map_t& m)
       {
          typedef typename inv_binary_op_map_t::value_type value_type;
 
@@ -35194,7 +36524,7 @@ namespace exprtk
          #undef register_binary_op
       }
 
-      inline void load_sf3_map(sf3_map_t& sf3_map)
+      static inline void load_sf3_map(sf3_map_t& sf3_map)
       {
          typedef std::pair<trinary_functor_t,details::operator_type> pair_t;
 
@@ -35218,7 +36548,7 @@ namespace exprtk
          #undef register_sf3_extid
       }
 
-      inline void load_sf4_map(sf4_map_t& sf4_map)
+      static inline void load_sf4_map(sf4_map_t& sf4_map)
       {
          typedef std::pair<quaternary_functor_t,details::operator_type> pair_t;
 
@@ -35281,6 +36611,95 @@ namespace exprtk
          #endif
       }
 
+      inline details::flow_control<T>& flow_ctrl()
+      {
+         if (0 == flow_control_)
+         {
+            flow_control_ = new details::flow_control<T>();
+         }
+
+         return (*flow_control_);
+      }
+
+      inline bool& flow_mode(const bool is_return)
+      {
+         bool* mode = flow_ctrl().create_mode();
+
+         if (is_return)
+            return_mode_list_.push_back(mode);
+         else
+            brkcnt_mode_list_.push_back(mode);
+
+         return (*mode);
+      }
+
+      inline void flow_cleanup()
+      {
+         if (flow_control_)
+         {
+            delete flow_control_;
+            flow_control_ = 0;
+         }
+
+         brkcnt_mode_list_.clear();
+         return_mode_list_.clear();
+      }
+
+      struct flow_mark
+      {
+         flow_mark(const std::size_t brkcnt, const std::size_t ret)
+         : brkcnt_index(brkcnt),
+           return_index(ret)
+         {}
+
+         std::size_t brkcnt_index;
+         std::size_t return_index;
+      };
+
+      inline flow_mark mark_flow() const
+      {
+         return flow_mark(brkcnt_mode_list_.size(), return_mode_list_.size());
+      }
+
+      // Any break, continue or return statements parsed since the mark
+      // that have not yet been bound to their enclosing loop?
+      inline bool flow_pending(const flow_mark& fm) const
+      {
+         return (brkcnt_mode_list_.size() > fm.brkcnt_index) ||
+                (return_mode_list_.size() > fm.return_index);
+      }
+
+      inline bool return_pending(const flow_mark& fm) const
+      {
+         return (return_mode_list_.size() > fm.return_index);
+      }
+
+      // Statements parsed since the mark are not in statement position
+      // (eg: they are operands of an operator or a function call), so
+      // they must fall back to unwinding the evaluation via exceptions.
+      inline void flow_throw_mode(const flow_mark& fm)
+      {
+         for (std::size_t i = fm.brkcnt_index; i < brkcnt_mode_list_.size(); ++i)
+         {
+            (*brkcnt_mode_list_[i]) = true;
+         }
+
+         for (std::size_t i = fm.return_index; i < return_mode_list_.size(); ++i)
+         {
+            (*return_mode_list_[i]) = true;
+         }
+      }
+
+      // A loop has been completed, break and continue statements parsed
+      // since the mark belong to it and need no further processing.
+      inline void bind_flow(const flow_mark& fm)
+      {
+         if (brkcnt_mode_list_.size() > fm.brkcnt_index)
+         {
+            brkcnt_mode_list_.resize(fm.brkcnt_index);
+         }
+      }
+
    private:
 
       parser(const parser<T>&);
@@ -35296,14 +36715,19 @@ namespace exprtk
       parser_state state_;
       bool resolve_unknown_symbol_;
       results_context_t* results_context_;
+      details::flow_control<T>* flow_control_;
+      expression_profile* profile_;
+      loop_runtime_check_ptr loop_runtime_check_;
+      std::vector<bool*> brkcnt_mode_list_;
+      std::vector<bool*> return_mode_list_;
       unknown_symbol_resolver* unknown_symbol_resolver_;
       unknown_symbol_resolver default_usr_;
-      base_ops_map_t base_ops_map_;
-      unary_op_map_t unary_op_map_;
-      binary_op_map_t binary_op_map_;
-      inv_binary_op_map_t inv_binary_op_map_;
-      sf3_map_t sf3_map_;
-      sf4_map_t sf4_map_;
+      const base_ops_map_t& base_ops_map_;
+      const unary_op_map_t& unary_op_map_;
+      const binary_op_map_t& binary_op_map_;
+      const inv_binary_op_map_t& inv_binary_op_map_;
+      const sf3_map_t& sf3_map_;
+      const sf4_map_t& sf4_map_;
       std::string synthesis_error_;
       scope_element_manager sem_;
 
@@ -36077,6 +37501,286 @@ namespace exprtk
       }
    };
 
+   template <typename T>
+   class function_cache
+   {
+   public:
+
+      struct statistics
+      {
+         statistics()
+         : hits(0),
+           misses(0),
+           evictions(0)
+         {}
+
+         inline double hit_rate() const
+         {
+            const std::size_t total = hits + misses;
+            return (total) ? static_cast<double>(hits) / total : 0.0;
+         }
+
+         std::size_t hits;
+         std::size_t misses;
+         std::size_t evictions;
+      };
+
+      function_cache(const std::size_t& arg_count = 0, const std::size_t& capacity = 0)
+      {
+         reset(arg_count,capacity);
+      }
+
+      inline void reset(const std::size_t& arg_count, const std::size_t& capacity)
+      {
+         // Two-way set associative, capacity rounded up to a power of two
+         std::size_t size = (capacity && arg_count) ? 2 : 0;
+
+         while ((size != 0) && (size < capacity))
+         {
+            size <<= 1;
+         }
+
+         arg_count_ = arg_count;
+         mask_      = (size) ? ((size >> 1) - 1) : 0;
+
+         keys_  .assign(size * arg_count, T(0));
+         values_.assign(size, T(0));
+         valid_ .assign(size, 0);
+         recent_.assign(size >> 1, 0);
+
+         stats_ = statistics();
+      }
+
+      inline void clear()
+      {
+         std::fill(valid_.begin(), valid_.end(), 0);
+      }
+
+      inline bool enabled() const
+      {
+         return !valid_.empty();
+      }
+
+      inline std::size_t capacity() const
+      {
+         return valid_.size();
+      }
+
+      inline const statistics& stats() const
+      {
+         return stats_;
+      }
+
+      inline bool lookup(const T* args, std::size_t& slot, T& result)
+      {
+         if (!enabled())
+            return false;
+
+         const std::size_t set = index(args);
+
+         for (std::size_t way = 0; way < 2; ++way)
+         {
+            slot = (set << 1) + way;
+
+            if (
+                 valid_[slot] &&
+                 std::equal(args, args + arg_count_, &keys_[slot * arg_count_])
+               )
+            {
+               ++stats_.hits;
+               recent_[set] = static_cast<unsigned char>(way);
+               result = values_[slot];
+               return true;
+            }
+         }
+
+         // Replace an empty or the least recently used way
+         if (!valid_[set << 1])
+            slot = (set << 1);
+         else if (!valid_[(set << 1) + 1])
+            slot = (set << 1) + 1;
+         else
+            slot = (set << 1) + (1 - recent_[set]);
+
+         ++stats_.misses;
+
+         return false;
+      }
+
+      inline const T& insert(const std::size_t& slot, const T* args, const T& result)
+      {
+         if (enabled())
+         {
+            if (valid_[slot])
+               ++stats_.evictions;
+
+            std::copy(args, args + arg_count_, &keys_[slot * arg_count_]);
+            values_[slot] = result;
+            valid_ [slot] = 1;
+            recent_[slot >> 1] = static_cast<unsigned char>(slot & 1);
+         }
+
+         return result;
+      }
+
+   private:
+
+      inline std::size_t index(const T* args) const
+      {
+         // Hash the double representation of the arguments, keys are
+         // compared exactly so precision loss only affects distribution.
+         unsigned long long hash = 0;
+
+         for (std::size_t i = 0; i < arg_count_; ++i)
+         {
+            const double d = (args[i] == T(0)) ? 0.0 : static_cast<double>(args[i]);
+            unsigned long long bits = 0;
+
+            std::memcpy(&bits, &d, sizeof(d) < sizeof(bits) ? sizeof(d) : sizeof(bits));
+
+            hash = (hash ^ bits) * 0x9E3779B97F4A7C15ULL;
+            hash ^= (hash >> 32);
+         }
+
+         // 64-bit finaliser (MurmurHash3)
+         hash ^= (hash >> 33);
+         hash *= 0xFF51AFD7ED558CCDULL;
+         hash ^= (hash >> 33);
+         hash *= 0xC4CEB9FE1A85EC53ULL;
+         hash ^= (hash >> 33);
+
+         return static_cast<std::size_t>(hash) & mask_;
+      }
+
+      std::size_t arg_count_;
+      std::size_t mask_;
+      std::vector<T> keys_;
+      std::vector<T> values_;
+      std::vector<unsigned char> valid_;
+      std::vector<unsigned char> recent_;
+      statistics stats_;
+   };
+
+   template <typename T>
+   class memoized_function : public ifunction<T>
+   {
+   public:
+
+      // Caches the results of a side effect free function of up
+      // to six parameters, functions with side effects are passed
+      // through unchanged.
+
+      typedef function_cache<T> cache_t;
+
+      using ifunction<T>::operator();
+
+      explicit memoized_function(ifunction<T>& f, const std::size_t& capacity = 1024)
+      : ifunction<T>(f.param_count),
+        function_(f)
+      {
+         this->allow_zero_parameters() = f.allow_zero_parameters();
+         this->has_side_effects()      = f.has_side_effects();
+
+         if (!f.has_side_effects() && (f.param_count <= 6))
+            cache_.reset(f.param_count, capacity);
+      }
+
+      virtual ~memoized_function()
+      {}
+
+      inline const typename cache_t::statistics& stats() const
+      {
+         return cache_.stats();
+      }
+
+      inline void clear()
+      {
+         cache_.clear();
+      }
+
+      inline T operator() ()
+      {
+         return function_();
+      }
+
+      inline T operator() (const T& v0)
+      {
+         const T key[] = { v0 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0));
+      }
+
+      inline T operator() (const T& v0, const T& v1)
+      {
+         const T key[] = { v0, v1 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0, v1));
+      }
+
+      inline T operator() (const T& v0, const T& v1, const T& v2)
+      {
+         const T key[] = { v0, v1, v2 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0, v1, v2));
+      }
+
+      inline T operator() (const T& v0, const T& v1, const T& v2, const T& v3)
+      {
+         const T key[] = { v0, v1, v2, v3 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0, v1, v2, v3));
+      }
+
+      inline T operator() (const T& v0, const T& v1, const T& v2, const T& v3, const T& v4)
+      {
+         const T key[] = { v0, v1, v2, v3, v4 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0, v1, v2, v3, v4));
+      }
+
+      inline T operator() (const T& v0, const T& v1, const T& v2, const T& v3, const T& v4, const T& v5)
+      {
+         const T key[] = { v0, v1, v2, v3, v4, v5 };
+         std::size_t slot = 0;
+         T result;
+
+         if (cache_.lookup(key, slot, result))
+            return result;
+
+         return cache_.insert(slot, key, function_(v0, v1, v2, v3, v4, v5));
+      }
+
+   private:
+
+      ifunction<T>& function_;
+      cache_t cache_;
+   };
+
    template <typename T>
    class function_compositor
    {
@@ -36090,23 +37794,27 @@ namespace exprtk
       struct function
       {
          function()
+         : cache_size_(0)
          {}
 
          function(const std::string& n)
-         : name_(n)
+         : name_(n),
+           cache_size_(0)
          {}
 
          function(const std::string& name,
                   const std::string& expression)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {}
 
          function(const std::string& name,
                   const std::string& expression,
                   const std::string& v0)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {
             v_.push_back(v0);
          }
@@ -36115,7 +37823,8 @@ namespace exprtk
                   const std::string& expression,
                   const std::string& v0, const std::string& v1)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {
             v_.push_back(v0); v_.push_back(v1);
          }
@@ -36125,7 +37834,8 @@ namespace exprtk
                   const std::string& v0, const std::string& v1,
                   const std::string& v2)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {
             v_.push_back(v0); v_.push_back(v1);
             v_.push_back(v2);
@@ -36136,7 +37846,8 @@ namespace exprtk
                   const std::string& v0, const std::string& v1,
                   const std::string& v2, const std::string& v3)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {
             v_.push_back(v0); v_.push_back(v1);
             v_.push_back(v2); v_.push_back(v3);
@@ -36148,7 +37859,8 @@ namespace exprtk
                   const std::string& v2, const std::string& v3,
                   const std::string& v4)
          : name_(name),
-           expression_(expression)
+           expression_(expression),
+           cache_size_(0)
          {
             v_.push_back(v0); v_.push_back(v1);
             v_.push_back(v2); v_.push_back(v3);
@@ -36173,9 +37885,18 @@ namespace exprtk
             return (*this);
          }
 
+         // Declares the function side effect free (eligible for
+         // constant folding) and caches up to 'capacity' results.
+         inline function& memoize(const std::size_t& capacity = 1024)
+         {
+            cache_size_ = capacity;
+            return (*this);
+         }
+
          std::string name_;
          std::string expression_;
          std::deque<std::string> v_;
+         std::size_t cache_size_;
       };
 
    private:
@@ -36380,12 +38101,19 @@ namespace exprtk
             }
          }
 
+         inline void memoize(const std::size_t& capacity)
+         {
+            cache.reset(v.size(),capacity);
+            disable_has_side_effects(*this);
+         }
+
          inline virtual T value(expression_t& e)
          {
             return e.value();
          }
 
          expression_t expression;
+         function_cache<T> cache;
          varref_t v;
          lvr_vec_t lv;
          std::size_t local_var_stack_size;
@@ -36432,9 +38160,16 @@ namespace exprtk
 
          inline T operator() (type v0)
          {
+            const T key[] = { v0 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_1param> sb(*this);
             base_func::update(v0);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36446,9 +38181,16 @@ namespace exprtk
 
          inline T operator() (type v0, type v1)
          {
+            const T key[] = { v0, v1 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_2param> sb(*this);
             base_func::update(v0, v1);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36460,9 +38202,16 @@ namespace exprtk
 
          inline T operator() (type v0, type v1, type v2)
          {
+            const T key[] = { v0, v1, v2 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_3param> sb(*this);
             base_func::update(v0, v1, v2);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36474,9 +38223,16 @@ namespace exprtk
 
          inline T operator() (type v0, type v1, type v2, type v3)
          {
+            const T key[] = { v0, v1, v2, v3 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_4param> sb(*this);
             base_func::update(v0, v1, v2, v3);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36488,9 +38244,16 @@ namespace exprtk
 
          inline T operator() (type v0, type v1, type v2, type v3, type v4)
          {
+            const T key[] = { v0, v1, v2, v3, v4 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_5param> sb(*this);
             base_func::update(v0, v1, v2, v3, v4);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36502,9 +38265,16 @@ namespace exprtk
 
          inline T operator() (type v0, type v1, type v2, type v3, type v4, type v5)
          {
+            const T key[] = { v0, v1, v2, v3, v4, v5 };
+            std::size_t slot = 0;
+            T result;
+
+            if (base_func::cache.lookup(key, slot, result))
+               return result;
+
             scoped_bft<func_6param> sb(*this);
             base_func::update(v0, v1, v2, v3, v4, v5);
-            return this->value(base_func::expression);
+            return base_func::cache.insert(slot, key, this->value(base_func::expression));
          }
       };
 
@@ -36549,7 +38319,8 @@ namespace exprtk
       inline bool add(const std::string& name,
                       const std::string& expression,
                       const Sequence<std::string,Allocator>& var_list,
-                      const bool override = false)
+                      const bool override = false,
+                      const std::size_t& cache_size = 0)
       {
          const typename std::map<std::string,expression_t>::iterator itr = expr_map_.find(name);
 
@@ -36566,12 +38337,24 @@ namespace exprtk
             remove(name, var_list.size());
          }
 
-         if (compile_expression(name,expression,var_list))
+         // Substitute calls to previously added small functions
+         const std::string body = (inline_threshold_) ? inline_expression(expression) : expression;
+
+         if (compile_expression(name,body,var_list))
          {
             const std::size_t n = var_list.size();
 
             fp_map_[n][name]->setup(expr_map_[name]);
 
+            if (cache_size)
+            {
+               fp_map_[n][name]->memoize(cache_size);
+            }
+            else if (inline_threshold_)
+            {
+               register_inline(name,body,var_list);
+            }
+
             return true;
          }
          else
@@ -36588,14 +38371,16 @@ namespace exprtk
       function_compositor()
       : parser_(settings_t::compile_all_opts +
                 settings_t::e_disable_zero_return),
-        fp_map_(7)
+        fp_map_(7),
+        inline_threshold_(0)
       {}
 
       function_compositor(const symbol_table_t& st)
       : symbol_table_(st),
         parser_(settings_t::compile_all_opts +
                 settings_t::e_disable_zero_return),
-        fp_map_(7)
+        fp_map_(7),
+        inline_threshold_(0)
       {}
 
      ~function_compositor()
@@ -36617,6 +38402,7 @@ namespace exprtk
       {
          symbol_table_.clear();
          expr_map_    .clear();
+         inline_map_  .clear();
 
          for (std::size_t i = 0; i < fp_map_.size(); ++i)
          {
@@ -36635,7 +38421,103 @@ namespace exprtk
 
       inline bool add(const function& f, const bool override = false)
       {
-         return add(f.name_, f.expression_, f.v_,override);
+         return add(f.name_, f.expression_, f.v_, override, f.cache_size_);
+      }
+
+      inline bool cache_stats(const std::string& name,
+                              typename function_cache<T>::statistics& stats) const
+      {
+         for (std::size_t i = 0; i < fp_map_.size(); ++i)
+         {
+            const typename funcparam_t::const_iterator itr = fp_map_[i].find(name);
+
+            if (fp_map_[i].end() != itr)
+            {
+               stats = itr->second->cache.stats();
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+      // Functions added after this call whose bodies are side effect
+      // free expressions of at most 'max_tokens' tokens, referring only
+      // to their parameters and to functions, become inline candidates.
+      inline void enable_inlining(const std::size_t& max_tokens = 32)
+      {
+         inline_threshold_ = max_tokens;
+      }
+
+      inline void disable_inlining()
+      {
+         inline_threshold_ = 0;
+      }
+
+      // Substitutes calls to inline candidates by their bodies, the
+      // result can be compiled by any parser that sees the functions
+      // called from within those bodies.
+      std::string inline_expression(const std::string& expression) const
+      {
+         if (inline_map_.empty())
+            return expression;
+
+         lexer::generator lexer;
+
+         if (!lexer.process(expression))
+            return expression;
+
+         std::string result;
+         std::size_t last = 0;
+
+         for (std::size_t i = 0; i < lexer.size(); ++i)
+         {
+            if (
+                 (lexer::token::e_symbol   != lexer[i    ].type) ||
+                 (lexer::token::e_lbracket != lexer[i + 1].type)
+               )
+               continue;
+
+            const typename inline_map_t::const_iterator itr = inline_map_.find(lexer[i].value);
+
+            if (inline_map_.end() == itr)
+               continue;
+
+            std::vector<std::size_t> delimiters;
+
+            if (!split_arguments(lexer, i + 1, delimiters))
+               continue;
+
+            std::string call;
+
+            if (!instantiate(itr->second, expression, lexer, delimiters, call))
+               continue;
+
+            result += expression.substr(last, lexer[i].position - last);
+            result += call;
+
+            last = lexer[delimiters.back()].position + 1;
+            i    = delimiters.back();
+         }
+
+         if (0 == last)
+            return expression;
+
+         return result + expression.substr(last);
+      }
+
+      void clear_caches()
+      {
+         for (std::size_t i = 0; i < fp_map_.size(); ++i)
+         {
+            typename funcparam_t::iterator itr = fp_map_[i].begin();
+            typename funcparam_t::iterator end = fp_map_[i].end  ();
+
+            while (itr != end)
+            {
+               (itr++)->second->cache.clear();
+            }
+         }
       }
 
    private:
@@ -36793,6 +38675,8 @@ namespace exprtk
          if (arg_count > 6)
             return;
 
+         inline_map_.erase(name);
+
          const typename std::map<std::string,expression_t>::iterator em_itr = expr_map_.find(name);
 
          if (expr_map_.end() != em_itr)
@@ -36811,6 +38695,248 @@ namespace exprtk
          symbol_table_.remove_function(name);
       }
 
+      struct inline_def
+      {
+         typedef std::pair<std::size_t,std::size_t> param_ref_t;
+
+         std::string body;
+         std::vector<std::string> params;
+         std::vector<std::size_t> use_count;
+         std::vector<param_ref_t> param_refs; // (body position, parameter index)
+      };
+
+      typedef std::map<std::string,inline_def,details::ilesscompare> inline_map_t;
+
+      static inline bool is_control_word(const std::string& symbol)
+      {
+         static const std::string control_words[] =
+                                     {
+                                       "break", "case", "continue", "default", "for", "repeat",
+                                       "return", "swap", "switch", "until", "var", "while"
+                                     };
+
+         static const std::size_t control_words_size = sizeof(control_words) / sizeof(std::string);
+
+         for (std::size_t i = 0; i < control_words_size; ++i)
+         {
+            if (details::imatch(symbol, control_words[i]))
+            {
+               return true;
+            }
+         }
+
+         return false;
+      }
+
+      static inline bool is_side_effect_token(const lexer::token& t)
+      {
+         switch (t.type)
+         {
+            case lexer::token::e_assign      : case lexer::token::e_addass      :
+            case lexer::token::e_subass      : case lexer::token::e_mulass      :
+            case lexer::token::e_divass      : case lexer::token::e_modass      :
+            case lexer::token::e_swap        : case lexer::token::e_eof         :
+            case lexer::token::e_lcrlbracket : case lexer::token::e_rcrlbracket :
+            case lexer::token::e_lsqrbracket : case lexer::token::e_rsqrbracket :
+            case lexer::token::e_string      : return true;
+
+            default                          : return false;
+         }
+      }
+
+      // Index of the call's opening bracket, its top level commas and
+      // its closing bracket (last).
+      static bool split_arguments(lexer::generator& lexer,
+                                  const std::size_t& open,
+                                  std::vector<std::size_t>& delimiters)
+      {
+         int depth = 0;
+
+         for (std::size_t i = open; i < lexer.size(); ++i)
+         {
+            switch (lexer[i].type)
+            {
+               case lexer::token::e_lbracket    :
+               case lexer::token::e_lsqrbracket :
+               case lexer::token::e_lcrlbracket : if (0 == depth++)
+                                                     delimiters.push_back(i);
+                                                  break;
+
+               case lexer::token::e_rbracket    :
+               case lexer::token::e_rsqrbracket :
+               case lexer::token::e_rcrlbracket : if (0 == --depth)
+                                                  {
+                                                     delimiters.push_back(i);
+                                                     return true;
+                                                  }
+                                                  else if (depth < 0)
+                                                     return false;
+                                                  break;
+
+               case lexer::token::e_comma       : if (1 == depth)
+                                                     delimiters.push_back(i);
+                                                  break;
+
+               default                          : break;
+            }
+         }
+
+         return false;
+      }
+
+      bool is_pure_argument(lexer::generator& lexer,
+                            const std::size_t& begin,
+                            const std::size_t& end) const
+      {
+         for (std::size_t i = begin; i < end; ++i)
+         {
+            const lexer::token& t = lexer[i];
+
+            if (is_side_effect_token(t))
+               return false;
+            else if (
+                      (lexer::token::e_symbol   == t.type) &&
+                      (lexer::token::e_lbracket == lexer[i + 1].type)
+                    )
+            {
+               if (is_control_word(t.value))
+                  return false;
+               else if (
+                         !details::is_reserved_symbol(t.value) &&
+                         (inline_map_.end() == inline_map_.find(t.value))
+                       )
+                  return false;
+            }
+         }
+
+         return true;
+      }
+
+      bool instantiate(const inline_def& def,
+                       const std::string& expression,
+                       lexer::generator& lexer,
+                       const std::vector<std::size_t>& delimiters,
+                       std::string& call) const
+      {
+         const std::size_t arg_count = delimiters.size() - 1;
+
+         // f() has a single (empty) argument slot
+         const bool empty_call = (2 == delimiters.size()) &&
+                                 (delimiters[1] == delimiters[0] + 1);
+
+         if ((empty_call ? 0 : arg_count) != def.params.size())
+            return false;
+
+         std::vector<std::string> args(def.params.size());
+
+         for (std::size_t i = 0; i < args.size(); ++i)
+         {
+            const std::size_t begin = delimiters[i] + 1;
+            const std::size_t end   = delimiters[i + 1];
+
+            if (begin == end)
+               return false;
+
+            const bool single = (1 == (end - begin)) &&
+                                (
+                                  (lexer::token::e_number == lexer[begin].type) ||
+                                  (lexer::token::e_symbol == lexer[begin].type)
+                                );
+
+            // Arguments are substituted textually, so only single tokens
+            // may be duplicated and only pure arguments may be reordered.
+            if (!single && ((def.use_count[i] > 1) || !is_pure_argument(lexer, begin, end)))
+               return false;
+
+            const std::size_t arg_begin = lexer[begin].position;
+            const std::size_t arg_end   = lexer[end  ].position;
+
+            args[i] = inline_expression(expression.substr(arg_begin, arg_end - arg_begin));
+         }
+
+         std::size_t last = 0;
+
+         call = "(";
+
+         for (std::size_t i = 0; i < def.param_refs.size(); ++i)
+         {
+            const std::size_t position = def.param_refs[i].first;
+            const std::size_t index    = def.param_refs[i].second;
+
+            call += def.body.substr(last, position - last);
+            call += "(" + args[index] + ")";
+
+            last = position + def.params[index].size();
+         }
+
+         call += def.body.substr(last) + ")";
+
+         return true;
+      }
+
+      template <typename Allocator,
+                template <typename, typename> class Sequence>
+      void register_inline(const std::string& name,
+                           const std::string& body,
+                           const Sequence<std::string,Allocator>& var_list)
+      {
+         lexer::generator lexer;
+
+         if (!lexer.process(body))
+            return;
+
+         // Ignore trailing statement terminators
+         std::size_t token_count = lexer.size();
+
+         while (token_count && (lexer::token::e_eof == lexer[token_count - 1].type))
+         {
+            --token_count;
+         }
+
+         if ((0 == token_count) || (token_count > inline_threshold_))
+            return;
+
+         inline_def def;
+
+         def.body = body.substr(0, lexer[token_count - 1].position + lexer[token_count - 1].value.size());
+         def.params.assign(var_list.begin(), var_list.end());
+         def.use_count.resize(def.params.size(), 0);
+
+         for (std::size_t i = 0; i < token_count; ++i)
+         {
+            const lexer::token& t = lexer[i];
+
+            if (is_side_effect_token(t))
+               return;
+            else if (lexer::token::e_symbol != t.type)
+               continue;
+
+            std::size_t index = 0;
+
+            while ((index < def.params.size()) && !details::imatch(t.value, def.params[index]))
+            {
+               ++index;
+            }
+
+            if (index < def.params.size())
+            {
+               def.param_refs.push_back(std::make_pair(t.position, index));
+               ++def.use_count[index];
+            }
+            else if (lexer::token::e_lbracket == lexer[i + 1].type)
+            {
+               // Calls to itself or to control structures stay out of line
+               if (details::imatch(t.value, name) || is_control_word(t.value))
+                  return;
+            }
+            // Free variables could be shadowed at the call site
+            else if (!details::is_reserved_word(t.value) || is_control_word(t.value))
+               return;
+         }
+
+         inline_map_[name] = def;
+      }
+
    private:
 
       symbol_table_t symbol_table_;
@@ -36818,6 +38944,8 @@ namespace exprtk
       std::map<std::string,expression_t> expr_map_;
       std::vector<funcparam_t> fp_map_;
       std::vector<symbol_table_t*> auxiliary_symtab_list_;
+      inline_map_t inline_map_;
+      std::size_t inline_threshold_;
    };
 
    template <typename T>
@@ -37274,7 +39402,24 @@ namespace exprtk
 #endif
 
 #ifndef exprtk_disable_rtl_io_file
-#include <fstream>
+#include <cerrno>
+#if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+#   include <cstdio>
+#else
+#   include <fcntl.h>
+#   include <sys/stat.h>
+#   include <sys/types.h>
+#   include <sys/uio.h>
+#   include <unistd.h>
+#   ifndef exprtk_disable_rtl_io_file_mmap
+#      include <sys/mman.h>
+#   endif
+#endif
+
+#ifndef exprtk_rtl_io_file_buffer_size
+#define exprtk_rtl_io_file_buffer_size (1 << 20)
+#endif
+
 namespace exprtk
 {
    namespace rtl { namespace io { namespace file { namespace details
@@ -37287,133 +39432,355 @@ namespace exprtk
          e_rdwrt = 4
       };
 
-      struct file_descriptor
+      #if defined(_WIN32) || defined(__WIN32__) || defined(WIN32)
+      struct native_file
       {
-         file_descriptor(const std::string& fname, const std::string& access)
-         : stream_ptr(0),
-           mode(get_file_mode(access)),
-           file_name(fname)
+         typedef std::FILE* handle_t;
+
+         static inline handle_t invalid()
+         {
+            return reinterpret_cast<handle_t>(0);
+         }
+
+         static inline handle_t open(const std::string& file_name, const file_mode mode)
+         {
+            const char* access = (e_read  == mode) ? "rb" :
+                                 (e_write == mode) ? "wb" : "r+b";
+
+            std::FILE* fp = std::fopen(file_name.c_str(),access);
+
+            // Buffering is done by the file descriptor
+            if (fp)
+               std::setvbuf(fp, 0, _IONBF, 0);
+
+            return fp;
+         }
+
+         static inline void close(handle_t h)
+         {
+            std::fclose(h);
+         }
+
+         static inline std::size_t read(handle_t h, char* data, const std::size_t size)
+         {
+            return std::fread(data, 1, size, h);
+         }
+
+         static inline bool write(handle_t h,
+                                  const char* data0, const std::size_t size0,
+                                  const char* data1, const std::size_t size1)
+         {
+            return (size0 == std::fwrite(data0, 1, size0, h)) &&
+                   (size1 == std::fwrite(data1, 1, size1, h)) ;
+         }
+
+         static inline bool rewind(handle_t h, const std::size_t amount)
+         {
+            return (0 == std::fseek(h, -static_cast<long>(amount), SEEK_CUR));
+         }
+
+         static inline const char* map(handle_t, std::size_t&)
+         {
+            return reinterpret_cast<const char*>(0);
+         }
+
+         static inline void unmap(const char*, const std::size_t)
          {}
+      };
+      #else
+      struct native_file
+      {
+         typedef int handle_t;
 
-         void*       stream_ptr;
-         file_mode   mode;
-         std::string file_name;
+         static inline handle_t invalid()
+         {
+            return -1;
+         }
 
-         bool open()
+         static inline handle_t open(const std::string& file_name, const file_mode mode)
          {
-            if (e_read == mode)
-            {
-               std::ifstream* stream = new std::ifstream(file_name.c_str(),std::ios::binary);
+            const int flags = (e_read  == mode) ? (O_RDONLY)                     :
+                              (e_write == mode) ? (O_WRONLY | O_CREAT | O_TRUNC) :
+                                                  (O_RDWR   | O_CREAT)           ;
 
-               if (!(*stream))
-               {
-                  file_name.clear();
-                  delete stream;
+            return ::open(file_name.c_str(), flags, 0666);
+         }
 
-                  return false;
-               }
-               else
-                  stream_ptr = stream;
+         static inline void close(handle_t h)
+         {
+            ::close(h);
+         }
 
-               return true;
+         static inline std::size_t read(handle_t h, char* data, const std::size_t size)
+         {
+            std::size_t total = 0;
+
+            while (total < size)
+            {
+               const ssize_t count = ::read(h, data + total, size - total);
+
+               if (count > 0)
+                  total += static_cast<std::size_t>(count);
+               else if ((count < 0) && (EINTR == errno))
+                  continue;
+               else
+                  break;
             }
-            else if (e_write == mode)
+
+            return total;
+         }
+
+         // Both parts leave in a single system call unless it is interrupted
+         static inline bool write(handle_t h,
+                                  const char* data0, const std::size_t size0,
+                                  const char* data1, const std::size_t size1)
+         {
+            struct iovec iov[2];
+
+            iov[0].iov_base = const_cast<char*>(data0);
+            iov[0].iov_len  = size0;
+            iov[1].iov_base = const_cast<char*>(data1);
+            iov[1].iov_len  = size1;
+
+            std::size_t index = 0;
+
+            for ( ; ; )
             {
-               std::ofstream* stream = new std::ofstream(file_name.c_str(),std::ios::binary);
+               while ((index < 2) && (0 == iov[index].iov_len))
+                  ++index;
 
-               if (!(*stream))
+               if (index >= 2)
+                  return true;
+
+               const ssize_t count = ::writev(h, iov + index, static_cast<int>(2 - index));
+
+               if (count < 0)
                {
-                  file_name.clear();
-                  delete stream;
+                  if (EINTR == errno)
+                     continue;
 
                   return false;
                }
-               else
-                  stream_ptr = stream;
+               else if (0 == count)
+                  return false;
 
-               return true;
+               std::size_t written = static_cast<std::size_t>(count);
+
+               while ((index < 2) && (written >= iov[index].iov_len))
+               {
+                  written -= iov[index].iov_len;
+                  iov[index++].iov_len = 0;
+               }
+
+               if (index < 2)
+               {
+                  iov[index].iov_base = static_cast<char*>(iov[index].iov_base) + written;
+                  iov[index].iov_len -= written;
+               }
             }
-            else if (e_rdwrt == mode)
+         }
+
+         static inline bool rewind(handle_t h, const std::size_t amount)
+         {
+            return (::lseek(h, -static_cast<off_t>(amount), SEEK_CUR) >= 0);
+         }
+
+         static inline const char* map(handle_t h, std::size_t& size)
+         {
+            #ifndef exprtk_disable_rtl_io_file_mmap
+            struct stat st;
+
+            if ((0 == ::fstat(h, &st)) && S_ISREG(st.st_mode) && (st.st_size > 0))
             {
-               std::fstream* stream = new std::fstream(file_name.c_str(),std::ios::binary);
+               void* data = ::mmap(0, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, h, 0);
 
-               if (!(*stream))
+               if (MAP_FAILED != data)
                {
-                  file_name.clear();
-                  delete stream;
+                  size = static_cast<std::size_t>(st.st_size);
+                  ::madvise(data, size, MADV_SEQUENTIAL);
 
-                  return false;
+                  return reinterpret_cast<const char*>(data);
                }
-               else
-                  stream_ptr = stream;
-
-               return true;
             }
-            else
-               return false;
+            #else
+            (void)h;
+            (void)size;
+            #endif
+
+            return reinterpret_cast<const char*>(0);
          }
 
-         template <typename Stream, typename Ptr>
-         void close(Ptr& p)
+         static inline void unmap(const char* data, const std::size_t size)
          {
-            Stream* stream = reinterpret_cast<Stream*>(p);
-            stream->close();
-            delete stream;
-            p = reinterpret_cast<Ptr>(0);
+            #ifndef exprtk_disable_rtl_io_file_mmap
+            ::munmap(const_cast<char*>(data), size);
+            #else
+            (void)data;
+            (void)size;
+            #endif
          }
+      };
+      #endif
 
-         bool close()
+      // Read-only files are memory mapped where possible, otherwise reads and
+      // writes go through a single user-space buffer of
+      // exprtk_rtl_io_file_buffer_size bytes. Buffered writes leave when the
+      // buffer fills up, on flush or on close.
+      struct file_descriptor
+      {
+         typedef native_file::handle_t handle_t;
+
+         file_descriptor(const std::string& fname, const std::string& access)
+         : mode(get_file_mode(access)),
+           file_name(fname),
+           handle(native_file::invalid()),
+           map_data(reinterpret_cast<const char*>(0)),
+           map_size(0),
+           begin(0),
+           end(0),
+           pending(0),
+           eof_reached(false)
+         {}
+
+        ~file_descriptor()
          {
-            switch (mode)
-            {
-               case e_read  : close<std::ifstream>(stream_ptr);
-                              break;
+            close();
+         }
 
-               case e_write : close<std::ofstream>(stream_ptr);
-                              break;
+         file_mode         mode;
+         std::string       file_name;
+         handle_t          handle;
+         const char*       map_data;
+         std::size_t       map_size;
+         std::vector<char> buffer;
+         std::size_t       begin;
+         std::size_t       end;
+         std::size_t       pending;
+         bool              eof_reached;
 
-               case e_rdwrt : close<std::fstream> (stream_ptr);
-                              break;
+         bool open()
+         {
+            if (e_error == mode)
+               return false;
 
-               default      : return false;
+            handle = native_file::open(file_name,mode);
+
+            if (native_file::invalid() == handle)
+            {
+               file_name.clear();
+
+               return false;
             }
 
+            if (e_read == mode)
+               map_data = native_file::map(handle,map_size);
+
+            if (map_data)
+               end = map_size;
+            else
+               buffer.resize(exprtk_rtl_io_file_buffer_size);
+
             return true;
          }
 
+         bool close()
+         {
+            if (native_file::invalid() == handle)
+               return false;
+
+            flush();
+
+            if (map_data)
+               native_file::unmap(map_data,map_size);
+
+            native_file::close(handle);
+
+            handle   = native_file::invalid();
+            map_data = reinterpret_cast<const char*>(0);
+
+            return true;
+         }
+
+         bool flush()
+         {
+            if (0 == pending)
+               return true;
+
+            const bool result = native_file::write(handle, &buffer[0], pending, 0, 0);
+
+            pending = 0;
+
+            return result;
+         }
+
          template <typename View>
          bool write(const View& view, const std::size_t amount, const std::size_t offset = 0)
          {
-            switch (mode)
-            {
-               case e_write : reinterpret_cast<std::ofstream*>(stream_ptr)->
-                                 write(reinterpret_cast<const char*>(view.begin() + offset), amount * sizeof(typename View::value_t));
-                              break;
+            if ((e_write != mode) && (e_rdwrt != mode))
+               return false;
+            else if (!discard_input())
+               return false;
 
-               case e_rdwrt : reinterpret_cast<std::fstream*>(stream_ptr)->
-                                 write(reinterpret_cast<const char*>(view.begin() + offset) , amount * sizeof(typename View::value_t));
-                              break;
+            const char*       source = reinterpret_cast<const char*>(view.begin() + offset);
+            const std::size_t size   = amount * sizeof(typename View::value_t);
 
-               default      : return false;
+            if ((pending + size) <= buffer.size())
+            {
+               if (size)
+               {
+                  std::memcpy(&buffer[pending], source, size);
+                  pending += size;
+               }
+
+               return true;
             }
 
-            return true;
+            // Buffered and new data leave together in one vectored write
+            const bool result = native_file::write(handle, &buffer[0], pending, source, size);
+
+            pending = 0;
+
+            return result;
          }
 
          template <typename View>
          bool read(View& view, const std::size_t amount, const std::size_t offset = 0)
          {
-            switch (mode)
+            if ((e_read != mode) && (e_rdwrt != mode))
+               return false;
+            else if (!flush())
+               return false;
+
+            char*       destination = reinterpret_cast<char*>(view.begin() + offset);
+            std::size_t size        = amount * sizeof(typename View::value_t);
+
+            while (size)
             {
-               case e_read  : reinterpret_cast<std::ifstream*>(stream_ptr)->
-                                 read(reinterpret_cast<char*>(view.begin() + offset), amount * sizeof(typename View::value_t));
-                              break;
+               if (begin == end)
+               {
+                  // Large reads bypass the buffer
+                  if (!map_data && (size >= buffer.size()))
+                  {
+                     if (native_file::read(handle, destination, size) < size)
+                        eof_reached = true;
 
-               case e_rdwrt : reinterpret_cast<std::fstream*>(stream_ptr)->
-                                 read(reinterpret_cast<char*>(view.begin() + offset) , amount * sizeof(typename View::value_t));
-                              break;
+                     return true;
+                  }
+                  else if (!fill())
+                  {
+                     eof_reached = true;
 
-               default      : return false;
+                     return true;
+                  }
+               }
+
+               const std::size_t count = std::min(size, end - begin);
+
+               std::memcpy(destination, data() + begin, count);
+
+               begin       += count;
+               destination += count;
+               size        -= count;
             }
 
             return true;
@@ -37421,23 +39788,73 @@ namespace exprtk
 
          bool getline(std::string& s)
          {
-            switch (mode)
+            if ((e_read != mode) && (e_rdwrt != mode))
+               return false;
+            else if (!flush())
+               return false;
+
+            s.clear();
+
+            bool extracted = false;
+
+            for ( ; ; )
             {
-               case e_read  : return (!!std::getline(*reinterpret_cast<std::ifstream*>(stream_ptr),s));
-               case e_rdwrt : return (!!std::getline(*reinterpret_cast<std::fstream* >(stream_ptr),s));
-               default      : return false;
+               if ((begin == end) && !fill())
+               {
+                  eof_reached = true;
+
+                  return extracted;
+               }
+
+               const char* first = data() + begin;
+               const char* last  = reinterpret_cast<const char*>(std::memchr(first, '\n', end - begin));
+
+               if (last)
+               {
+                  s.append(first,last);
+                  begin += static_cast<std::size_t>(last - first) + 1;
+
+                  return true;
+               }
+
+               s.append(first, end - begin);
+               begin     = end;
+               extracted = true;
             }
          }
 
          bool eof() const
          {
-            switch (mode)
-            {
-               case e_read  : return reinterpret_cast<std::ifstream*>(stream_ptr)->eof();
-               case e_write : return reinterpret_cast<std::ofstream*>(stream_ptr)->eof();
-               case e_rdwrt : return reinterpret_cast<std::fstream* >(stream_ptr)->eof();
-               default      : return true;
-            }
+            return (e_error == mode) || eof_reached;
+         }
+
+         inline const char* data() const
+         {
+            return map_data ? map_data : &buffer[0];
+         }
+
+         bool fill()
+         {
+            if (map_data)
+               return false;
+
+            begin = 0;
+            end   = native_file::read(handle, &buffer[0], buffer.size());
+
+            return (end > 0);
+         }
+
+         // Writes continue where the reader left off, not at the read-ahead
+         bool discard_input()
+         {
+            if (begin == end)
+               return true;
+
+            const std::size_t unread = end - begin;
+
+            begin = end = 0;
+
+            return native_file::rewind(handle,unread);
          }
 
          file_mode get_file_mode(const std::string& access) const
@@ -37728,6 +40145,23 @@ namespace exprtk
       }
    };
 
+   template <typename T>
+   struct flush : public exprtk::ifunction<T>
+   {
+      using exprtk::ifunction<T>::operator();
+
+      flush()
+      : exprtk::ifunction<T>(1)
+      { details::perform_check<T>(); }
+
+      inline T operator() (const T& v)
+      {
+         details::file_descriptor* fd = details::make_handle(v);
+
+         return (fd->flush() ? T(1) : T(0));
+      }
+   };
+
    template <typename T>
    struct package
    {
@@ -37737,6 +40171,7 @@ namespace exprtk
       read   <T> r;
       getline<T> g;
       eof    <T> e;
+      flush  <T> f;
 
       bool register_package(exprtk::symbol_table<T>& symtab)
       {
@@ -37755,6 +40190,7 @@ namespace exprtk
          exprtk_register_function("read"   ,r)
          exprtk_register_function("getline",g)
          exprtk_register_function("eof"    ,e)
+         exprtk_register_function("flush"  ,f)
          #undef exprtk_register_function
 
          return true;
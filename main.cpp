@@ -1,10 +1,75 @@
 #include "arithm_dialog.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+
+    QCommandLineOption profileOption("profile",
+                                     QApplication::translate("main", "Print the evaluation profile of <expression> as JSON and exit."),
+                                     "expression");
+    parser.addOption(profileOption);
+
+    QCommandLineOption libraryOption("build-library",
+                                     QApplication::translate("main", "Compile the formulas in <file>, one per line, into the library and exit."),
+                                     "file");
+    parser.addOption(libraryOption);
+
+    QCommandLineOption dataOption("data",
+                                  QApplication::translate("main", "Evaluate <expression> over the rows of <file>, write them to the output file and exit."),
+                                  "file");
+    parser.addOption(dataOption);
+
+    QCommandLineOption outputOption("output",
+                                    QApplication::translate("main", "Output <file> of --data."),
+                                    "file");
+    parser.addOption(outputOption);
+    parser.addPositionalArgument("expression", QApplication::translate("main", "Expression evaluated by --data."));
+    parser.process(a);
+
     ArithmDialog w;
+
+    if(parser.isSet(profileOption))
+    {
+        QTextStream(stdout) << w.Profile(parser.value(profileOption)) << "\n";
+        return 0;
+    }
+
+    if(parser.isSet(libraryOption))
+    {
+        const int count = w.BuildLibrary(parser.value(libraryOption));
+
+        if(count < 0)
+            return 1;
+
+        QTextStream(stdout) << count << "\n";
+        return 0;
+    }
+
+    if(parser.isSet(dataOption))
+    {
+        if(!parser.isSet(outputOption) || parser.positionalArguments().size() != 1)
+            parser.showHelp(1);
+
+        QString error;
+        const qint64 rows = w.EvaluateData(parser.positionalArguments().first(),
+                                           parser.value(dataOption), parser.value(outputOption), error);
+
+        if(rows < 0)
+        {
+            QTextStream(stderr) << error << "\n";
+            return 1;
+        }
+
+        QTextStream(stdout) << rows << "\n";
+        return 0;
+    }
+
     w.show();
 
     // nothing to see here, please move along.
@@ -14,6 +14,12 @@
 #define HISTORY_COUNT_DEFAULT   10
 
 #define HISTORY_ENTRY_KEY      "History/Entry_"
+#define HISTORY_JOURNAL_FILE    "Arithm.history"
+#define HISTORY_COMPLETION_LIMIT    20
+#define HISTORY_RECORD_DELAY        1000
+
+#define HISTORY_PRECOMPILE_KEY      "History/Precompile"
+#define HISTORY_PRECOMPILE_DEFAULT  64
 
 // Plot
 #define PLOT_X_MIN_KEY          "Plot/X_Min"
@@ -23,11 +29,77 @@
 #define PLOT_X_MAX_DEFAULT      6
 
 #define PLOT_ZOOM_FACTOR        1.2
+#define PLOT_TILES              4
+
+#define PLOT_FIELD_RESOLUTION_KEY       "Plot/Field_Resolution"
+#define PLOT_FIELD_RESOLUTION_DEFAULT   2
+
+#define PLOT_FIELD_CONTOURS_KEY         "Plot/Field_Contours"
+#define PLOT_FIELD_CONTOURS_DEFAULT     10
+
+#define PLOT_IMPLICIT_DEPTH     6
+
+#define PLOT_T_MIN_DEFAULT      0.0
+#define PLOT_T_MAX_DEFAULT      6.283185307179586
+#define PLOT_UNIFORM_SHARE      0.2
+
+#define PLOT_SWEEP_MIN_DEFAULT  1.0
+#define PLOT_SWEEP_MAX_DEFAULT  10.0
+#define PLOT_SWEEP_STEP_DEFAULT 1.0
+#define PLOT_SWEEP_MEMBERS      256
+#define PLOT_SWEEP_CACHE        1024
 
 #define PLOT_SAMPLES_KEY        "Plot/Samples"
 #define PLOT_SAMPLES_DEFAULT    2048
 #define PLOT_SAMPLES_MIN        2
 #define PLOT_SAMPLES_MAX        16384
+#define PLOT_COARSE_SAMPLES     64
+#define PLOT_NUMBERED_CURVES    64
+
+#define PLOT_JUMP_FACTOR        8
+#define PLOT_BISECTIONS         12
+#define PLOT_MAX_SUSPECTS       64
+#define PLOT_POLE_WINDOW        0.02
+
+#define PLOT_MAX_ROOTS          64
+#define PLOT_ROOT_PAIRS         4
+#define PLOT_ROOT_ITERATIONS    64
+#define PLOT_POINTS_LISTED      8
+
+#define PLOT_MAX_EXTREMA        64
+#define PLOT_EXTREMA_CACHE      1024
+#define PLOT_GOLDEN_ITERATIONS  40
+#define PLOT_EXTREMUM_MARGIN    0.001
+#define PLOT_CURVATURE_NOISE    1e-9
 
 #define PLOT_THEME_KEY          "Plot/Theme"
 #define PLOT_THEME_DEFAULT      QChart::ChartThemeLight
+
+#define PLOT_RENDERER_KEY       "Plot/Renderer"
+#define PLOT_RENDERER_CHARTS    0
+#define PLOT_RENDERER_PAINTER   1
+#define PLOT_RENDERER_DEFAULT   PLOT_RENDERER_CHARTS
+
+// Runtime
+#define RUNTIME_MAX_ITERATIONS_KEY      "Runtime/Max_Iterations"
+#define RUNTIME_MAX_ITERATIONS_DEFAULT  1000000
+
+#define RUNTIME_TIMEOUT_KEY             "Runtime/Timeout"
+#define RUNTIME_TIMEOUT_DEFAULT         2000
+
+#define RUNTIME_PROFILE_KEY             "Runtime/Profile"
+#define RUNTIME_PROFILE_DEFAULT         0
+#define RUNTIME_PROFILE_ENTRIES         5
+
+#define RUNTIME_LIBRARY_KEY             "Runtime/Library"
+#define RUNTIME_LIBRARY_DEFAULT         "Arithm.lib"
+
+#define RUNTIME_CACHE_KEY               "Runtime/Cache"
+#define RUNTIME_CACHE_DEFAULT           1
+#define RUNTIME_CACHE_DIRECTORY         "Arithm.cache"
+
+// Data
+#define DATA_BLOCK_ROWS         4096
+#define DATA_BLOCKS_PER_THREAD  2
+#define DATA_COLUMN_MAGIC       "ACOL"
+#define DATA_COLUMN_VERSION     1